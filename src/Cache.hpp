@@ -0,0 +1,534 @@
+/**
+ * @file Cache.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for bounded key value caches, which evict the least recently or least frequently used entry.
+ * @date 2022-05-16
+ */
+
+#ifndef CACHE_H
+#define CACHE_H
+
+#include <algorithm>
+#include <functional>
+#include <utility>
+
+#include "IntrusiveList.hpp"
+#include "IntrusiveTree.hpp"
+#include "Pool.hpp"
+
+namespace DM852 {
+    /**
+     * @brief A cache of at most capacity entries, which evicts the least recently used entry when a new one is put in.
+     *          Every entry is one pool object, which is linked into an IntrusiveTree by key and into an IntrusiveList
+     *          by recency, so a hit is a lookup in the tree and relinking the entry to the front of the list.
+     *          Hits do not allocate, and a put into a full cache reuses the slot of the evicted entry.
+     *          Not thread safe.
+     * @tparam Key type of the keys.
+     * @tparam Value type of the values.
+     * @tparam Comp compare function object of the keys.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    struct LruCache {
+        /**
+         * @brief Called with the key and value of an entry right before it is evicted. The value can be moved from.
+         *          It must not use the cache.
+         */
+        using evict_function = std::function<void(const Key&, Value&)>;
+
+        /**
+         * @brief Construct a new empty LruCache object.
+         * @param capacity largest number of entries, at least 1.
+         * @param on_evict function called for every evicted entry, can be empty.
+         * @param compare function object for the keys.
+         */
+        explicit LruCache(int capacity, evict_function on_evict = evict_function(), Comp compare = Comp())
+            : index(0.57f, KeyOf(), compare), max_entries(std::max(capacity, 1)), on_evict(std::move(on_evict)) {}
+
+        LruCache(const LruCache& other) = delete;
+        LruCache& operator=(const LruCache& other) = delete;
+
+        /**
+         * @brief Destroy the LruCache object and all entries. The evict function is not called.
+         */
+        ~LruCache() {
+            clear();
+        }
+
+        /**
+         * @brief Finds the value of a key, and marks the entry as the most recently used.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return Value* the value, valid until the entry is evicted or erased. nullptr if the key is not cached.
+         */
+        Value* get(const Key& key) {
+            auto it = index.find(key);
+            if(it == index.end())
+                return nullptr;
+            order.move_to_front(*it);
+            return &it->value;
+        }
+
+        /**
+         * @brief Finds the value of a key, without marking it as used.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return const Value* the value, nullptr if the key is not cached.
+         */
+        const Value* peek(const Key& key) const {
+            auto it = index.find(key);
+            return it == index.end() ? nullptr : &it->value;
+        }
+
+        /**
+         * @brief Checks if a key is cached, without marking it as used.
+         * @param key to find.
+         * @return true if the key is cached.
+         */
+        bool contains(const Key& key) const {
+            return peek(key) != nullptr;
+        }
+
+        /**
+         * @brief Sets the value of a key, and marks it as the most recently used.
+         *          If the key is new and the cache is full, the least recently used entry is evicted first.
+         *
+         *          Runtime: O(log n)
+         * @param key of the entry.
+         * @param value of the entry.
+         * @return true if the key was not cached before.
+         */
+        bool put(const Key& key, const Value& value) {
+            return put_entry(key, value);
+        }
+
+        /**
+         * @brief Overloaded put(), by moving.
+         * @param key rvalue key of the entry.
+         * @param value rvalue value of the entry.
+         * @return true if the key was not cached before.
+         */
+        bool put(Key&& key, Value&& value) {
+            return put_entry(std::move(key), std::move(value));
+        }
+
+        /**
+         * @brief Removes the entry of a key. The evict function is not called.
+         *          Runtime: O(log n)
+         * @param key of the entry.
+         * @return true if the key was cached.
+         */
+        bool erase(const Key& key) {
+            auto it = index.find(key);
+            if(it == index.end())
+                return false;
+            remove(&*it);
+            return true;
+        }
+
+        /**
+         * @brief Evicts the least recently used entry, and calls the evict function on it.
+         *          Does nothing if the cache is empty.
+         *          Runtime: O(log n)
+         */
+        void evict() {
+            if(order.empty()) return;
+            Entry* e = &order.back();
+            if(on_evict)
+                on_evict(e->key, e->value);
+            remove(e);
+        }
+
+        /**
+         * @brief Changes the capacity. Entries are evicted until the cache fits.
+         * @param capacity largest number of entries, at least 1.
+         */
+        void set_capacity(int capacity) {
+            max_entries = std::max(capacity, 1);
+            while(size() > max_entries)
+                evict();
+        }
+
+        /**
+         * @return int the largest number of entries.
+         */
+        int capacity() const {
+            return max_entries;
+        }
+
+        /**
+         * @return int the number of entries.
+         */
+        int size() const {
+            return order.size();
+        }
+
+        /**
+         * @return true if there are no entries.
+         */
+        bool empty() const {
+            return order.empty();
+        }
+
+        /**
+         * @brief Removes all entries. The evict function is not called.
+         *          Runtime: O(n)
+         */
+        void clear() {
+            index.clear();
+            while(!order.empty()) {
+                Entry* e = &order.front();
+                order.pop_front();
+                entries.destroy(e);
+            }
+        }
+
+        private:
+            /**
+             * @brief An entry is linked into both the index and the recency list.
+             */
+            struct Entry {
+                Key key;
+                Value value;
+                ListHook<Entry> lru;
+                TreeHook<Entry> by_key;
+
+                template<typename K, typename V>
+                Entry(K&& key, V&& value) : key(std::forward<K>(key)), value(std::forward<V>(value)) {}
+            };
+
+            struct KeyOf {
+                const Key& operator()(const Entry& e) const {
+                    return e.key;
+                }
+            };
+
+            Pool<Entry> entries; // declared first, so it outlives the containers the entries are linked into
+            IntrusiveList<Entry, &Entry::lru> order; // the most recently used entry is at the front
+            IntrusiveTree<Entry, &Entry::by_key, KeyOf, Comp> index;
+            int max_entries;
+            evict_function on_evict;
+
+            /**
+             * @brief Sets or inserts an entry, see put().
+             */
+            template<typename K, typename V>
+            bool put_entry(K&& key, V&& value) {
+                auto it = index.find(key);
+                if(it != index.end()) {
+                    it->value = std::forward<V>(value);
+                    order.move_to_front(*it);
+                    return false;
+                }
+                if(size() >= max_entries)
+                    evict(); // frees a slot, which the new entry takes
+                Entry* e = entries.create(std::forward<K>(key), std::forward<V>(value));
+                index.insert(*e);
+                order.push_front(*e);
+                return true;
+            }
+
+            /**
+             * @brief Unlinks and destroys an entry.
+             * @param e entry of the cache.
+             */
+            void remove(Entry* e) {
+                index.erase(*e);
+                order.erase(*e);
+                entries.destroy(e);
+            }
+    };
+
+    /**
+     * @brief A cache of at most capacity entries, which evicts the least frequently used entry when a new one is put in,
+     *          and of those the least recently used.
+     *          The entries are kept in buckets of the same use count, and the buckets in a list sorted by count,
+     *          so a hit moves the entry to the next bucket in O(1), and the entry to evict is the last of the first bucket.
+     *          This is the O(1) LFU scheme of "An O(1) algorithm for implementing the LFU cache eviction scheme"
+     *          by Shah, Mitra and Matani, with the hash map replaced by an IntrusiveTree.
+     *          Entries and buckets are pool objects, so hits do not call the allocator once the pools are warm.
+     *          Not thread safe.
+     * @tparam Key type of the keys.
+     * @tparam Value type of the values.
+     * @tparam Comp compare function object of the keys.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    struct LfuCache {
+        /**
+         * @brief Called with the key and value of an entry right before it is evicted. The value can be moved from.
+         *          It must not use the cache.
+         */
+        using evict_function = std::function<void(const Key&, Value&)>;
+
+        /**
+         * @brief Construct a new empty LfuCache object.
+         * @param capacity largest number of entries, at least 1.
+         * @param on_evict function called for every evicted entry, can be empty.
+         * @param compare function object for the keys.
+         */
+        explicit LfuCache(int capacity, evict_function on_evict = evict_function(), Comp compare = Comp())
+            : index(0.57f, KeyOf(), compare), max_entries(std::max(capacity, 1)), on_evict(std::move(on_evict)) {}
+
+        LfuCache(const LfuCache& other) = delete;
+        LfuCache& operator=(const LfuCache& other) = delete;
+
+        /**
+         * @brief Destroy the LfuCache object and all entries. The evict function is not called.
+         */
+        ~LfuCache() {
+            clear();
+        }
+
+        /**
+         * @brief Finds the value of a key, and counts a use of the entry.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return Value* the value, valid until the entry is evicted or erased. nullptr if the key is not cached.
+         */
+        Value* get(const Key& key) {
+            auto it = index.find(key);
+            if(it == index.end())
+                return nullptr;
+            touch(&*it);
+            return &it->value;
+        }
+
+        /**
+         * @brief Finds the value of a key, without counting a use.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return const Value* the value, nullptr if the key is not cached.
+         */
+        const Value* peek(const Key& key) const {
+            auto it = index.find(key);
+            return it == index.end() ? nullptr : &it->value;
+        }
+
+        /**
+         * @brief Checks if a key is cached, without counting a use.
+         * @param key to find.
+         * @return true if the key is cached.
+         */
+        bool contains(const Key& key) const {
+            return peek(key) != nullptr;
+        }
+
+        /**
+         * @brief Returns how often an entry has been used, counting the put that inserted it.
+         * @param key of the entry.
+         * @return int use count, 0 if the key is not cached.
+         */
+        int frequency(const Key& key) const {
+            auto it = index.find(key);
+            return it == index.end() ? 0 : it->bucket->freq;
+        }
+
+        /**
+         * @brief Sets the value of a key, and counts a use of it.
+         *          If the key is new and the cache is full, the least frequently used entry is evicted first.
+         *
+         *          Runtime: O(log n)
+         * @param key of the entry.
+         * @param value of the entry.
+         * @return true if the key was not cached before.
+         */
+        bool put(const Key& key, const Value& value) {
+            return put_entry(key, value);
+        }
+
+        /**
+         * @brief Overloaded put(), by moving.
+         * @param key rvalue key of the entry.
+         * @param value rvalue value of the entry.
+         * @return true if the key was not cached before.
+         */
+        bool put(Key&& key, Value&& value) {
+            return put_entry(std::move(key), std::move(value));
+        }
+
+        /**
+         * @brief Removes the entry of a key. The evict function is not called.
+         *          Runtime: O(log n)
+         * @param key of the entry.
+         * @return true if the key was cached.
+         */
+        bool erase(const Key& key) {
+            auto it = index.find(key);
+            if(it == index.end())
+                return false;
+            remove(&*it);
+            return true;
+        }
+
+        /**
+         * @brief Evicts the least frequently used entry, and calls the evict function on it.
+         *          Does nothing if the cache is empty.
+         *          Runtime: O(log n)
+         */
+        void evict() {
+            if(buckets.empty()) return;
+            Entry* e = &buckets.front().entries.back();
+            if(on_evict)
+                on_evict(e->key, e->value);
+            remove(e);
+        }
+
+        /**
+         * @brief Changes the capacity. Entries are evicted until the cache fits.
+         * @param capacity largest number of entries, at least 1.
+         */
+        void set_capacity(int capacity) {
+            max_entries = std::max(capacity, 1);
+            while(size() > max_entries)
+                evict();
+        }
+
+        /**
+         * @return int the largest number of entries.
+         */
+        int capacity() const {
+            return max_entries;
+        }
+
+        /**
+         * @return int the number of entries.
+         */
+        int size() const {
+            return index.size();
+        }
+
+        /**
+         * @return true if there are no entries.
+         */
+        bool empty() const {
+            return index.empty();
+        }
+
+        /**
+         * @brief Removes all entries. The evict function is not called.
+         *          Runtime: O(n)
+         */
+        void clear() {
+            index.clear();
+            while(!buckets.empty()) {
+                Bucket* b = &buckets.front();
+                while(!b->entries.empty()) {
+                    Entry* e = &b->entries.front();
+                    b->entries.pop_front();
+                    entries.destroy(e);
+                }
+                buckets.pop_front();
+                bucket_pool.destroy(b);
+            }
+        }
+
+        private:
+            struct Bucket;
+
+            /**
+             * @brief An entry is linked into the index and into the list of its bucket.
+             */
+            struct Entry {
+                Key key;
+                Value value;
+                Bucket* bucket = nullptr;
+                ListHook<Entry> in_bucket;
+                TreeHook<Entry> by_key;
+
+                template<typename K, typename V>
+                Entry(K&& key, V&& value) : key(std::forward<K>(key)), value(std::forward<V>(value)) {}
+            };
+
+            /**
+             * @brief The entries with the same use count, the most recently used at the front.
+             */
+            struct Bucket {
+                int freq;
+                IntrusiveList<Entry, &Entry::in_bucket> entries;
+                ListHook<Bucket> hook;
+
+                explicit Bucket(int freq) : freq(freq) {}
+            };
+
+            struct KeyOf {
+                const Key& operator()(const Entry& e) const {
+                    return e.key;
+                }
+            };
+
+            // the pools are declared first, so they outlive the containers the objects are linked into
+            Pool<Entry> entries;
+            Pool<Bucket> bucket_pool;
+            IntrusiveList<Bucket, &Bucket::hook> buckets; // sorted by freq, no bucket is empty
+            IntrusiveTree<Entry, &Entry::by_key, KeyOf, Comp> index;
+            int max_entries;
+            evict_function on_evict;
+
+            /**
+             * @brief Sets or inserts an entry, see put().
+             */
+            template<typename K, typename V>
+            bool put_entry(K&& key, V&& value) {
+                auto it = index.find(key);
+                if(it != index.end()) {
+                    it->value = std::forward<V>(value);
+                    touch(&*it);
+                    return false;
+                }
+                if(size() >= max_entries)
+                    evict(); // frees a slot, which the new entry takes
+                Entry* e = entries.create(std::forward<K>(key), std::forward<V>(value));
+                index.insert(*e);
+                Bucket* first = buckets.empty() ? nullptr : &buckets.front();
+                if(!first || first->freq != 1) {
+                    first = bucket_pool.create(1);
+                    buckets.push_front(*first);
+                }
+                first->entries.push_front(*e);
+                e->bucket = first;
+                return true;
+            }
+
+            /**
+             * @brief Counts a use of an entry, by moving it to the bucket of the next count.
+             *          Runtime: O(1)
+             * @param e entry of the cache.
+             */
+            void touch(Entry* e) {
+                Bucket* b = e->bucket;
+                Bucket* next = b->hook.next;
+                if(!next || next->freq != b->freq + 1) {
+                    Bucket* nb = bucket_pool.create(b->freq + 1);
+                    buckets.insert(next ? buckets.iterator_to(*next) : buckets.end(), *nb);
+                    next = nb;
+                }
+                b->entries.erase(*e);
+                next->entries.push_front(*e);
+                e->bucket = next;
+                if(b->entries.empty())
+                    drop(b);
+            }
+
+            /**
+             * @brief Unlinks and destroys an entry, and its bucket if that is empty then.
+             * @param e entry of the cache.
+             */
+            void remove(Entry* e) {
+                Bucket* b = e->bucket;
+                index.erase(*e);
+                b->entries.erase(*e);
+                entries.destroy(e);
+                if(b->entries.empty())
+                    drop(b);
+            }
+
+            /**
+             * @brief Unlinks and destroys an empty bucket.
+             * @param b bucket of the cache.
+             */
+            void drop(Bucket* b) {
+                buckets.erase(*b);
+                bucket_pool.destroy(b);
+            }
+    };
+};
+#endif
@@ -0,0 +1,222 @@
+/**
+ * @file ConcurrentQueue.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for a queue which many threads can push to without a lock.
+ * @date 2022-05-16
+ */
+
+#ifndef CONCURRENT_QUEUE_H
+#define CONCURRENT_QUEUE_H
+
+#include <atomic>
+#include <climits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <utility>
+
+#include "List.hpp"
+
+namespace DM852 {
+    /**
+     * @brief A FIFO queue for passing work between threads, linked like List but with an atomic next pointer.
+     *          Any number of threads can push_back() at the same time without a lock: a producer swaps its node
+     *          into tail with one atomic exchange, and then links the previous node to it.
+     *          The queue always holds a dummy node at head, and popping moves the dummy to the first element,
+     *          so producers and consumers never touch the same pointer.
+     *          Described in "Non-intrusive MPSC node-based queue" by Dmitry Vyukov, which is a variant
+     *          of the queue in "Simple, Fast, and Practical Non-Blocking and Blocking Concurrent Queue Algorithms"
+     *          by Maged M. Michael and Michael L. Scott.
+     *
+     *          Only the consumer frees nodes, and it only frees the old dummy once the node after it is linked,
+     *          which is after the producer of that node is done with the old dummy.
+     *          So no node is freed while another thread can reach it, which is the safe reclamation.
+     *          With MultiConsumer, consumers take a mutex among themselves, which producers never touch.
+     *          With one consumer thread the mutex can be left out.
+     *
+     *          A pop can miss an element whose push has swapped tail but not yet linked it, so a queue with
+     *          a push in progress may look empty for a moment.
+     * @tparam T type of the elements.
+     * @tparam MultiConsumer false if only one thread ever pops.
+     */
+    template<typename T, bool MultiConsumer = true>
+    struct ConcurrentQueue {
+        using value_type = T;
+
+        /**
+         * @brief Construct a new empty ConcurrentQueue object.
+         */
+        ConcurrentQueue() {
+            Node* dummy = new Node;
+            head = dummy;
+            tail.store(dummy, std::memory_order_relaxed);
+        }
+
+        ConcurrentQueue(const ConcurrentQueue& other) = delete;
+        ConcurrentQueue& operator=(const ConcurrentQueue& other) = delete;
+
+        /**
+         * @brief Destroy the ConcurrentQueue object and the elements left in it.
+         *          No thread may use the queue any more.
+         */
+        ~ConcurrentQueue() {
+            Node* n = head;
+            Node* next = n->next.load(std::memory_order_relaxed);
+            delete n; // the dummy holds no element
+            for(n = next; n; n = next) {
+                next = n->next.load(std::memory_order_relaxed);
+                std::destroy_at(n->value());
+                delete n;
+            }
+        }
+
+        /**
+         * @brief Inserts an element at the back of the queue. Can be called from any number of threads at the same time.
+         *          Runtime: O(1), one allocation and one atomic exchange, wait-free apart from the allocation.
+         * @param elem value_type to insert.
+         */
+        void push_back(const value_type& elem) {
+            link(new Node(elem));
+        }
+
+        /**
+         * @brief Inserts an element at the back of the queue, by moving. Can be called from any number of threads at the same time.
+         *          Runtime: O(1), one allocation and one atomic exchange, wait-free apart from the allocation.
+         * @param elem rvalue value_type to insert by moving.
+         */
+        void push_back(value_type&& elem) {
+            link(new Node(std::move(elem)));
+        }
+
+        /**
+         * @brief Removes the element at the front of the queue.
+         *          Runtime: O(1)
+         * @return std::optional<value_type> the element, empty if the queue is empty.
+         */
+        std::optional<value_type> try_pop_front() {
+            Consumer guard(*this);
+            Node* first = head->next.load(std::memory_order_acquire);
+            if(!first) return std::nullopt;
+            std::optional<value_type> res(std::move(*first->value()));
+            pop(first);
+            return res;
+        }
+
+        /**
+         * @brief Removes the elements at the front of the queue, up to max of them, and calls f on each in order.
+         *          The consumer mutex is taken once for the whole batch.
+         *          f must not pop from this queue, and if f throws the element it was given is lost.
+         *
+         *          Runtime: O(k), k is the number of elements removed.
+         * @param f function which is called with a value_type&&.
+         * @param max largest number of elements to remove.
+         * @return int number of elements removed.
+         */
+        template<typename F>
+        int drain(F&& f, int max = INT_MAX) {
+            Consumer guard(*this);
+            int count = 0;
+            for(; count < max; count++) {
+                Node* first = head->next.load(std::memory_order_acquire);
+                if(!first) break;
+                struct Pop { // free the old dummy even if f throws
+                    ConcurrentQueue& q;
+                    Node* first;
+                    ~Pop() { q.pop(first); }
+                } popper{*this, first};
+                f(std::move(*first->value()));
+            }
+            return count;
+        }
+
+        /**
+         * @brief Overloaded drain(), which moves the elements to the back of a list.
+         * @param out list to push the elements to.
+         * @param max largest number of elements to remove.
+         * @return int number of elements removed.
+         */
+        int drain(List<value_type>& out, int max = INT_MAX) {
+            return drain([&out](value_type&& elem) { out.push_back(std::move(elem)); }, max);
+        }
+
+        /**
+         * @brief Checks if there is an element to pop. Other threads can change that right after.
+         * @return true if the queue is empty.
+         */
+        bool empty() const {
+            Consumer guard(*this);
+            return head->next.load(std::memory_order_acquire) == nullptr;
+        }
+
+        private:
+            /**
+             * @brief Nested Node class. The element is constructed in place, so the dummy holds none.
+             */
+            struct Node {
+                std::atomic<Node*> next = nullptr;
+                alignas(T) unsigned char data[sizeof(T)];
+
+                Node() = default;
+
+                /**
+                 * @brief Construct a new Node object with an element.
+                 * @param elem to store in the node, copied or moved.
+                 */
+                template<typename U>
+                explicit Node(U&& elem) {
+                    new (data) T(std::forward<U>(elem));
+                }
+
+                /**
+                 * @return T* the element of the node.
+                 */
+                T* value() {
+                    return std::launder(reinterpret_cast<T*>(data));
+                }
+            };
+
+            /**
+             * @brief Takes the consumer mutex for a scope, if there can be more than one consumer.
+             */
+            struct Consumer {
+                const ConcurrentQueue& q;
+
+                explicit Consumer(const ConcurrentQueue& q) : q(q) {
+                    if constexpr(MultiConsumer)
+                        q.consumer.lock();
+                }
+
+                ~Consumer() {
+                    if constexpr(MultiConsumer)
+                        q.consumer.unlock();
+                }
+            };
+
+            // head is only used by the consumer and tail by the producers, so they get a cache line each
+            alignas(64) Node* head;
+            alignas(64) std::atomic<Node*> tail;
+            alignas(64) mutable std::mutex consumer;
+
+            /**
+             * @brief Links a new node in at the back.
+             * @param node the new node.
+             */
+            void link(Node* node) {
+                Node* prev = tail.exchange(node, std::memory_order_acq_rel);
+                prev->next.store(node, std::memory_order_release);
+            }
+
+            /**
+             * @brief Makes the first node the dummy, after its element has been moved out, and frees the old dummy.
+             * @param first the node after the dummy.
+             */
+            void pop(Node* first) {
+                std::destroy_at(first->value());
+                Node* dummy = head;
+                head = first;
+                delete dummy;
+            }
+    };
+};
+#endif
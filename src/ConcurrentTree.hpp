@@ -0,0 +1,227 @@
+/**
+ * @file ConcurrentTree.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for a Scapegoat tree which many threads can read while one thread writes.
+ * @date 2022-05-16
+ */
+
+#ifndef CONCURRENT_TREE_H
+#define CONCURRENT_TREE_H
+
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#include "Tree.hpp"
+
+namespace DM852 {
+    /**
+     * @brief A Tree shared by many reader threads and writer threads, using the Left-Right technique.
+     *          There are two copies of the tree. Readers use the copy that left_right points to, and never
+     *          take a lock or wait. A writer changes the other copy, points the readers to it, waits until
+     *          no reader is left in the old copy, and then makes the same change to the old copy.
+     *          So a reader always sees a consistent version, and nodes freed by erase() or by a
+     *          rebuild are freed while no reader can reach them, which is the safe reclamation.
+     *          The price is twice the memory and doing every change twice. Writers are serialized by a mutex.
+     *
+     *          A reader announces itself on a read indicator: a counter per version, striped over
+     *          cache lines so readers on different cores do not share a counter, which is what lets
+     *          reads scale with the number of cores.
+     *          Described in "Left-Right: A Concurrency Control Technique with Wait-Free Population Oblivious Reads"
+     *          by Pedro Ramalhete and Andreia Correia.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    struct ConcurrentTree {
+        using tree_type = Tree<Key, Value, Comp>;
+
+        /**
+         * @brief Construct a new empty ConcurrentTree object.
+         */
+        ConcurrentTree() = default;
+
+        ConcurrentTree(const ConcurrentTree& other) = delete;
+        ConcurrentTree& operator=(const ConcurrentTree& other) = delete;
+
+        /**
+         * @brief Finds the value of a key. Can be called from any number of threads at the same time.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return std::optional<Value> a copy of the value, empty if the key is not in the tree.
+         */
+        std::optional<Value> find(const Key& key) const {
+            return read([&key](const tree_type& tree) -> std::optional<Value> {
+                auto it = tree.find(key);
+                if(it == tree.end())
+                    return std::nullopt;
+                return it->second;
+            });
+        }
+
+        /**
+         * @brief Checks if a key is in the tree. Can be called from any number of threads at the same time.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return true if the key is in the tree.
+         */
+        bool contains(const Key& key) const {
+            return read([&key](const tree_type& tree) {
+                return tree.find(key) != tree.end();
+            });
+        }
+
+        /**
+         * @brief Return size of tree.
+         * @return int
+         */
+        int size() const {
+            return read([](const tree_type& tree) {
+                return tree.size();
+            });
+        }
+
+        /**
+         * @brief Runs a function on a consistent version of the tree, for example a range scan.
+         *          The function must not keep iterators or references after it returns,
+         *          because the version may be changed by a writer after that.
+         *          A long function delays the writers, not the other readers.
+         *
+         *          Runtime: O(1) + the function.
+         * @param f function which is called with a const Tree&.
+         * @return the result of f.
+         */
+        template<typename F>
+        decltype(auto) read(F&& f) const {
+            int stripe = stripe_index();
+            int v = version.load();
+            indicator[v][stripe].count.fetch_add(1);
+            struct Depart { // leave the read indicator even if f throws
+                std::atomic<int>& count;
+                ~Depart() { count.fetch_sub(1); }
+            } depart{indicator[v][stripe].count};
+            return std::forward<F>(f)(std::as_const(trees[left_right.load()]));
+        }
+
+        /**
+         * @brief Inserts a node, or changes the value if the key exists. See Tree::insert().
+         *          Runtime: O_A(log n) - amortized, and waits for the readers of the old version.
+         * @param key of the node.
+         * @param value of the node.
+         * @return true if the node was inserted or its value was changed.
+         */
+        bool insert(const Key& key, const Value& value) {
+            bool res = false;
+            write([&](tree_type& tree) {
+                res = tree.insert(key, value).second;
+            });
+            return res;
+        }
+
+        /**
+         * @brief Assigns the value to the node with the key, or inserts a new node. See Tree::insert_or_assign().
+         *          Runtime: O_A(log n) - amortized, and waits for the readers of the old version.
+         * @param key of the node.
+         * @param value to assign or insert.
+         * @return true if the node was inserted.
+         */
+        bool insert_or_assign(const Key& key, const Value& value) {
+            bool res = false;
+            write([&](tree_type& tree) {
+                res = tree.insert_or_assign(key, value).second;
+            });
+            return res;
+        }
+
+        /**
+         * @brief Removes a node given the key. Does nothing if the key is not in the tree.
+         *          Runtime: O_A(log n) - amortized, and waits for the readers of the old version.
+         * @param key of node to remove.
+         */
+        void erase(const Key& key) {
+            write([&key](tree_type& tree) {
+                tree.erase(key);
+            });
+        }
+
+        /**
+         * @brief Destroys all nodes.
+         *          Runtime: O(n), and waits for the readers of the old version.
+         */
+        void clear() {
+            write([](tree_type& tree) {
+                tree.clear();
+            });
+        }
+
+        /**
+         * @brief Makes a change to the tree, for example a batch of inserts or a new alpha.
+         *          The function is called twice, once for each copy of the tree, so it must make the
+         *          same change both times, and it must not move from its captures.
+         *          Only one writer runs at a time.
+         *
+         *          Runtime: two calls of f, and waits for the readers of the old version.
+         * @param f function which is called with a Tree&.
+         */
+        template<typename F>
+        void write(F&& f) {
+            std::lock_guard<std::mutex> lock(writer);
+            int lr = left_right.load();
+            f(trees[lr ^ 1]);        // change the copy no reader uses
+            left_right.store(lr ^ 1); // new readers go to the changed copy
+            toggle_version_and_wait(); // readers already in the old copy leave it
+            f(trees[lr]);
+        }
+
+        private:
+            static constexpr int stripes = 64; // number of counters per read indicator
+
+            /**
+             * @brief A counter which fills a cache line, so two counters are never in the same line.
+             */
+            struct alignas(64) Counter {
+                std::atomic<int> count = 0;
+            };
+
+            tree_type trees[2];
+            std::atomic<int> left_right = 0; // the copy new readers use
+            std::atomic<int> version = 0;    // the read indicator new readers use
+            mutable Counter indicator[2][stripes];
+            std::mutex writer;
+
+            /**
+             * @brief Gives every thread its own counter of the read indicators, as long as there are
+             *          no more than stripes threads.
+             * @return int stripe of the calling thread.
+             */
+            static int stripe_index() {
+                static std::atomic<int> next = 0;
+                thread_local int index = next.fetch_add(1) % stripes;
+                return index;
+            }
+
+            /**
+             * @brief Waits until no reader is announced on a read indicator.
+             * @param v version of the read indicator.
+             */
+            void wait_empty(int v) const {
+                for(int i = 0; i < stripes; i++)
+                    while(indicator[v][i].count.load() != 0)
+                        std::this_thread::yield();
+            }
+
+            /**
+             * @brief Moves new readers to the other read indicator, and waits until both are empty
+             *          of readers which could have seen the old value of left_right.
+             */
+            void toggle_version_and_wait() {
+                int prev = version.load();
+                int next = prev ^ 1;
+                wait_empty(next); // readers left over from the previous write
+                version.store(next);
+                wait_empty(prev);
+            }
+    };
+};
+#endif
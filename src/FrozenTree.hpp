@@ -0,0 +1,307 @@
+/**
+ * @file FrozenTree.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for an immutable, array based snapshot of a search tree.
+ * @date 2022-05-16
+ */
+
+#ifndef FROZEN_TREE_H
+#define FROZEN_TREE_H
+
+#include <bit>
+#include <functional>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+namespace DM852 {
+    /**
+     * @brief A read only sorted map stored in contiguous arrays.
+     *          The pairs are stored in sorted order, so iteration is a linear scan.
+     *          The keys are also stored in Eytzinger (breadth first) order, which is the layout
+     *          of the perfectly balanced tree that Tree::build() makes, but without pointers:
+     *          the children of position k are 2k and 2k+1. The top levels of the search
+     *          share a few cache lines, and the next levels can be prefetched.
+     *
+     *          If Key is an arithmetic type and Comp is std::less, the keys are instead stored in
+     *          blocks of one cache line each, like the nodes of a B-tree with a fan-out of
+     *          B+1. A block is searched by comparing all its keys at once with AVX2 or NEON
+     *          and counting the hits, so there is one cache miss and no branches per level.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    struct FrozenTree {
+        using value_type = std::pair<const Key, Value>;
+        using const_iterator = typename std::vector<value_type>::const_iterator;
+
+        /**
+         * @brief Construct a new empty FrozenTree object.
+         */
+        FrozenTree() : comp(Comp()) {}
+
+        /**
+         * @brief Construct a new FrozenTree object from a range of pairs.
+         *          Pre-condition: the keys must be sorted and unique, as they are in a Tree.
+         *
+         *          Runtime: O(n)
+         * @param from iterator to the first pair.
+         * @param to past the end iterator of the range.
+         * @param compare Comp object.
+         */
+        template<typename InputIt>
+        FrozenTree(InputIt from, InputIt to, Comp compare = Comp()) : comp(compare) {
+            for(; from != to; ++from)
+                items.push_back(*from);
+            if constexpr(blocked) {
+                blocks.resize((items.size() + B - 1) / B);
+                index.resize(blocks.size() * B);
+                layout_blocks(0, 0);
+            } else {
+                index.resize(items.size() + 1); // position 0 is not used, so the root is at 1
+                layout(0, 1);
+                keys.reserve(items.size());
+                for(size_t k = 1; k <= items.size(); k++)
+                    keys.push_back(items[index[k]].first);
+            }
+        }
+
+        /**
+         * @brief Return size of the snapshot.
+         * @return int
+         */
+        int size() const {
+            return items.size();
+        }
+
+        /**
+         * @brief Checks if size of the snapshot is 0.
+         * @return true if size = 0
+         */
+        bool empty() const {
+            return items.empty();
+        }
+
+        /**
+         * @brief Finds a pair given a key.
+         *          Runtime: O(log n)
+         * @param key to find
+         * @return const_iterator at the position of the pair. past the end iterator if not found.
+         */
+        const_iterator find(const Key& key) const {
+            auto it = lower_bound(key);
+            if(it != end() && !comp(key, it->first))
+                return it;
+            return end();
+        }
+
+        /**
+         * @brief Finds the first pair whose key is not smaller than key.
+         *          Runtime: O(log n)
+         * @param key to search for.
+         * @return const_iterator at the position of the pair. past the end iterator if there is none.
+         */
+        const_iterator lower_bound(const Key& key) const {
+            return begin() + search(key, false);
+        }
+
+        /**
+         * @brief Finds the first pair whose key is bigger than key.
+         *          Runtime: O(log n)
+         * @param key to search for.
+         * @return const_iterator at the position of the pair. past the end iterator if there is none.
+         */
+        const_iterator upper_bound(const Key& key) const {
+            return begin() + search(key, true);
+        }
+
+        /**
+         * @return const_iterator at the position of the smallest pair.
+         */
+        const_iterator begin() const {
+            return items.begin();
+        }
+
+        /**
+         * @return past the end const_iterator.
+         */
+        const_iterator end() const {
+            return items.end();
+        }
+
+        private:
+            // Use the block layout and the vectorized search
+            static constexpr bool blocked = std::is_arithmetic_v<Key> &&
+                (std::is_same_v<Comp, std::less<Key>> || std::is_same_v<Comp, std::less<>>);
+            static constexpr int B = sizeof(Key) < 64 ? 64 / sizeof(Key) : 1; // keys per block
+
+            /**
+             * @brief B keys in one cache line. The children of block k are the blocks k*(B+1)+i+1 for i = 0..B
+             */
+            struct alignas(64) Block {
+                Key keys[B];
+            };
+
+            std::vector<value_type> items; // all pairs in sorted order
+            std::vector<Key> keys;         // keys in Eytzinger order, keys[k-1] is the key at position k
+            std::vector<Block> blocks;     // keys in block order, only used if blocked
+            std::vector<int> index;        // index[k] is the position in items of the key at position k
+            Comp comp;
+
+            /**
+             * @brief Fills blocks and index by walking the implicit B-tree inorder.
+             *          Slots after the last key get the biggest value of Key, and point past the end.
+             *          Runtime: O(n)
+             *
+             * @param i position in items of the next key to place.
+             * @param k block number of the subtree.
+             * @return int position in items after the subtree.
+             */
+            int layout_blocks(int i, size_t k) {
+                if(k >= blocks.size())
+                    return i;
+                for(int j = 0; j < B; j++) {
+                    i = layout_blocks(i, k * (B + 1) + j + 1);
+                    if(i < size()) {
+                        blocks[k].keys[j] = items[i].first;
+                        index[k * B + j] = i++;
+                    } else {
+                        if constexpr(std::numeric_limits<Key>::has_infinity)
+                            blocks[k].keys[j] = std::numeric_limits<Key>::infinity();
+                        else
+                            blocks[k].keys[j] = std::numeric_limits<Key>::max();
+                        index[k * B + j] = size();
+                    }
+                }
+                return layout_blocks(i, k * (B + 1) + B + 1);
+            }
+
+            /**
+             * @brief Counts the keys of a block that are smaller than key (or not bigger if upper).
+             *          Because the block is sorted, this is the child to continue in.
+             *          Uses AVX2 or NEON for 32 bit keys and 64 bit integer keys when available,
+             *          and a plain loop the compiler can vectorize otherwise.
+             *
+             * @param block to search in.
+             * @param key to search for.
+             * @param upper if true count the keys not bigger than key.
+             * @return int number of keys, between 0 and B.
+             */
+            static int block_rank(const Block& block, Key key, bool upper) {
+#if defined(__AVX2__)
+                if constexpr(std::is_integral_v<Key> && std::is_signed_v<Key> && sizeof(Key) == 4) {
+                    __m256i x = _mm256_set1_epi32(key);
+                    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.keys));
+                    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.keys + 8));
+                    // smaller: x > key[i], not bigger: !(key[i] > x)
+                    __m256i ca = upper ? _mm256_cmpgt_epi32(a, x) : _mm256_cmpgt_epi32(x, a);
+                    __m256i cb = upper ? _mm256_cmpgt_epi32(b, x) : _mm256_cmpgt_epi32(x, b);
+                    unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(ca)) | (_mm256_movemask_ps(_mm256_castsi256_ps(cb)) << 8);
+                    return upper ? B - std::popcount(mask) : std::popcount(mask);
+                } else if constexpr(std::is_integral_v<Key> && std::is_signed_v<Key> && sizeof(Key) == 8) {
+                    __m256i x = _mm256_set1_epi64x(key);
+                    __m256i a = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.keys));
+                    __m256i b = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.keys + 4));
+                    __m256i ca = upper ? _mm256_cmpgt_epi64(a, x) : _mm256_cmpgt_epi64(x, a);
+                    __m256i cb = upper ? _mm256_cmpgt_epi64(b, x) : _mm256_cmpgt_epi64(x, b);
+                    unsigned mask = _mm256_movemask_pd(_mm256_castsi256_pd(ca)) | (_mm256_movemask_pd(_mm256_castsi256_pd(cb)) << 4);
+                    return upper ? B - std::popcount(mask) : std::popcount(mask);
+                } else if constexpr(std::is_same_v<Key, float>) {
+                    __m256 x = _mm256_set1_ps(key);
+                    __m256 a = _mm256_load_ps(block.keys);
+                    __m256 b = _mm256_load_ps(block.keys + 8);
+                    __m256 ca = upper ? _mm256_cmp_ps(a, x, _CMP_LE_OQ) : _mm256_cmp_ps(a, x, _CMP_LT_OQ);
+                    __m256 cb = upper ? _mm256_cmp_ps(b, x, _CMP_LE_OQ) : _mm256_cmp_ps(b, x, _CMP_LT_OQ);
+                    return std::popcount(unsigned(_mm256_movemask_ps(ca) | (_mm256_movemask_ps(cb) << 8)));
+                } else
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+                if constexpr(std::is_integral_v<Key> && std::is_signed_v<Key> && sizeof(Key) == 4) {
+                    int32x4_t x = vdupq_n_s32(key);
+                    uint32x4_t sum = vdupq_n_u32(0);
+                    for(int j = 0; j < B; j += 4) { // every hit is all ones, shift it to 1 and add
+                        int32x4_t a = vld1q_s32(block.keys + j);
+                        sum = vaddq_u32(sum, vshrq_n_u32(upper ? vcleq_s32(a, x) : vcltq_s32(a, x), 31));
+                    }
+                    return vaddvq_u32(sum);
+                } else if constexpr(std::is_same_v<Key, float>) {
+                    float32x4_t x = vdupq_n_f32(key);
+                    uint32x4_t sum = vdupq_n_u32(0);
+                    for(int j = 0; j < B; j += 4) {
+                        float32x4_t a = vld1q_f32(block.keys + j);
+                        sum = vaddq_u32(sum, vshrq_n_u32(upper ? vcleq_f32(a, x) : vcltq_f32(a, x), 31));
+                    }
+                    return vaddvq_u32(sum);
+                } else
+#endif
+                {
+                    int res = 0;
+                    for(int j = 0; j < B; j++)
+                        res += upper ? !(key < block.keys[j]) : block.keys[j] < key;
+                    return res;
+                }
+            }
+
+            /**
+             * @brief Fills index by walking the implicit tree inorder.
+             *          The recursion depth is log2(n).
+             *          Runtime: O(n)
+             *
+             * @param i position in items of the next key to place.
+             * @param k Eytzinger position of the subtree.
+             * @return int position in items after the subtree.
+             */
+            int layout(int i, size_t k) {
+                if(k >= index.size())
+                    return i;
+                i = layout(i, 2 * k);
+                index[k] = i++;
+                return layout(i, 2 * k + 1);
+            }
+
+            /**
+             * @brief Branch free descent through the Eytzinger layout.
+             *          The descent always goes to the bottom, and the answer is found afterwards
+             *          from the bits of the final position: the last time the descent went left
+             *          is the position of the lower (or upper) bound.
+             *          With the block layout the descent visits one block per level instead,
+             *          and it goes to the child given by block_rank().
+             *          Runtime: O(log n)
+             *
+             * @param key to search for.
+             * @param upper if true, find the first key bigger than key, else the first key not smaller.
+             * @return int position in items of the result, size() if there is none.
+             */
+            int search(const Key& key, bool upper) const {
+                if constexpr(blocked) { // the deepest block with a key not smaller than key has the answer
+                    int res = size();
+                    size_t k = 0;
+                    while(k < blocks.size()) {
+                        int j = block_rank(blocks[k], key, upper);
+                        if(j < B)
+                            res = index[k * B + j];
+                        k = k * (B + 1) + j + 1;
+                    }
+                    return res;
+                }
+                size_t n = items.size();
+                size_t k = 1;
+                while(k <= n) {
+#if defined(__GNUC__)
+                    if(16 * k <= n) // the 16 descendants four levels down share a cache line for small keys
+                        __builtin_prefetch(keys.data() + 16 * k - 1);
+#endif
+                    const Key& k_key = keys[k - 1];
+                    bool right = upper ? !comp(key, k_key) : comp(k_key, key);
+                    k = 2 * k + right;
+                }
+                k >>= std::countr_one(k) + 1; // undo the right turns after the last left turn
+                return k == 0 ? n : index[k];
+            }
+    };
+};
+#endif
@@ -0,0 +1,370 @@
+/**
+ * @file IntrusiveList.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief A doubly linked list of objects which hold their own links.
+ *
+ * @date 2022-05-16
+ */
+#ifndef INTRUSIVE_LIST_H
+#define INTRUSIVE_LIST_H
+
+#include <utility>
+
+namespace DM852 {
+/**
+ * @brief The links an object needs to be in an IntrusiveList. An object can hold several hooks,
+ *          one for each list it can be in at the same time.
+ */
+template<typename T>
+struct ListHook {
+    T* prev = nullptr;
+    T* next = nullptr;
+};
+
+/**
+ * @brief A doubly linked list which links existing objects through a ListHook member, instead of
+ *          copying them into nodes. Inserting and erasing never allocate or copy, and an object
+ *          can be found in the list from a reference to it in O(1), see iterator_to().
+ *          The list does not own the objects: they must stay alive and in place while they are linked,
+ *          and must be erased from the list before they are destroyed.
+ *          An object can only be in one list per hook.
+ * @tparam T type of the objects.
+ * @tparam Hook the ListHook<T> member of T to link through, for example &Entry::lru.
+ */
+template<typename T, ListHook<T> T::*Hook>
+struct IntrusiveList {
+    using value_type = T;
+
+    struct iterator {
+        friend struct IntrusiveList;
+        using value_type = T;
+        using reference = value_type&;
+
+        /**
+         * @brief Default constructer.
+         */
+        iterator() : list(nullptr), ptr(nullptr) {}
+
+        /**
+         * @brief Construct a new iterator object.
+         * @param list the iterator belongs to.
+         * @param ptr object the iterator is at, nullptr for the past the end iterator.
+         */
+        iterator(const IntrusiveList* list, T* ptr) : list(list), ptr(ptr) {}
+
+        /**
+         * @brief Prefix increment.
+         * @return iterator& at the next object.
+         */
+        iterator& operator++() {
+            ptr = (ptr->*Hook).next;
+            return *this;
+        }
+
+        /**
+         * @brief Postfix increment.
+         * @return iterator at the object before the increment.
+         */
+        iterator operator++(int) {
+            iterator tmp = *this;
+            ++*this;
+            return tmp;
+        }
+
+        /**
+         * @brief Prefix decrement. Decrementing the past the end iterator gives the last object.
+         * @return iterator& at the previous object.
+         */
+        iterator& operator--() {
+            ptr = ptr ? (ptr->*Hook).prev : list->tail;
+            return *this;
+        }
+
+        /**
+         * @brief Postfix decrement.
+         * @return iterator at the object before the decrement.
+         */
+        iterator operator--(int) {
+            iterator tmp = *this;
+            --*this;
+            return tmp;
+        }
+
+        /**
+         * @return reference to the object.
+         */
+        reference operator*() const {
+            return *ptr;
+        }
+
+        /**
+         * @return T* the object.
+         */
+        T* operator->() const {
+            return ptr;
+        }
+
+        bool operator==(const iterator& rhs) const {
+            return ptr == rhs.ptr;
+        }
+
+        bool operator!=(const iterator& rhs) const {
+            return ptr != rhs.ptr;
+        }
+
+        private:
+            const IntrusiveList* list;
+            T* ptr;
+    };
+
+    /**
+     * @brief Construct a new empty IntrusiveList object.
+     */
+    IntrusiveList() {
+        head = tail = nullptr;
+        list_size = 0;
+    }
+
+    // an object can only be linked into one list through a hook, so a list cannot be copied
+    IntrusiveList(const IntrusiveList& other) = delete;
+    IntrusiveList& operator=(const IntrusiveList& other) = delete;
+
+    /**
+     * @brief Move Constructer. This list takes over the objects of other, which is empty afterwards.
+     * @param other list object.
+     */
+    IntrusiveList(IntrusiveList&& other) {
+        head = std::exchange(other.head, nullptr);
+        tail = std::exchange(other.tail, nullptr);
+        list_size = std::exchange(other.list_size, 0);
+    }
+
+    /**
+     * @brief Move Assignment operator. The objects of this list are unlinked, and it takes over the objects of other.
+     * @param other list object.
+     */
+    IntrusiveList& operator=(IntrusiveList&& other) {
+        if(this == &other) return *this;
+        clear();
+        head = std::exchange(other.head, nullptr);
+        tail = std::exchange(other.tail, nullptr);
+        list_size = std::exchange(other.list_size, 0);
+        return *this;
+    }
+
+    /**
+     * @brief Unlinks the objects left in the list. The objects themselves are not touched otherwise.
+     */
+    ~IntrusiveList() {
+        clear();
+    }
+
+    /**
+     * @brief Return size of list
+     * @return int
+     */
+    int size() const {
+        return list_size;
+    }
+
+    /**
+     * @return true if list is empty.
+     */
+    bool empty() const {
+        return list_size == 0;
+    }
+
+    /**
+     * @brief Links an object in at the end of the list.
+     *          Pre-condition: obj is not in a list through Hook.
+     *          Runtime: O(1)
+     * @param obj object to link.
+     */
+    void push_back(T& obj) {
+        link(nullptr, &obj);
+    }
+
+    /**
+     * @brief Links an object in at the start of the list.
+     *          Pre-condition: obj is not in a list through Hook.
+     *          Runtime: O(1)
+     * @param obj object to link.
+     */
+    void push_front(T& obj) {
+        link(head, &obj);
+    }
+
+    /**
+     * @brief Links an object in right before pos.
+     *          Pre-condition: pos is an iterator of this list, and obj is not in a list through Hook.
+     *          Runtime: O(1)
+     * @param pos iterator at the position to insert.
+     * @param obj object to link.
+     * @return iterator at obj.
+     */
+    iterator insert(iterator pos, T& obj) {
+        link(pos.ptr, &obj);
+        return iterator(this, &obj);
+    }
+
+    /**
+     * @brief Unlinks an object from the list. The object is not destroyed.
+     *          Pre-condition: obj is in this list.
+     *          Runtime: O(1)
+     * @param obj object to unlink.
+     */
+    void erase(T& obj) {
+        unlink(&obj);
+    }
+
+    /**
+     * @brief Unlinks the object at pos from the list.
+     *          Pre-condition: pos is an iterator at an object of this list.
+     *          Runtime: O(1)
+     * @param pos iterator at the object.
+     * @return iterator at the object after it.
+     */
+    iterator erase(iterator pos) {
+        T* next = (pos.ptr->*Hook).next;
+        unlink(pos.ptr);
+        return iterator(this, next);
+    }
+
+    /**
+     * @brief Unlinks the first object. Does nothing if the list is empty.
+     */
+    void pop_front() {
+        if(head)
+            unlink(head);
+    }
+
+    /**
+     * @brief Unlinks the last object. Does nothing if the list is empty.
+     */
+    void pop_back() {
+        if(tail)
+            unlink(tail);
+    }
+
+    /**
+     * @brief Moves an object of the list to the start, for example a cache entry that was just used.
+     *          Pre-condition: obj is in this list.
+     *          Runtime: O(1)
+     * @param obj object to move.
+     */
+    void move_to_front(T& obj) {
+        if(&obj == head) return;
+        unlink(&obj);
+        link(head, &obj);
+    }
+
+    /**
+     * @brief Moves an object of the list to the end.
+     *          Pre-condition: obj is in this list.
+     *          Runtime: O(1)
+     * @param obj object to move.
+     */
+    void move_to_back(T& obj) {
+        if(&obj == tail) return;
+        unlink(&obj);
+        link(nullptr, &obj);
+    }
+
+    /**
+     * @brief Unlinks all objects, and resets their hooks.
+     *          Runtime: O(n)
+     */
+    void clear() {
+        for(T* n = head; n;) {
+            T* next = (n->*Hook).next;
+            n->*Hook = ListHook<T>();
+            n = next;
+        }
+        head = tail = nullptr;
+        list_size = 0;
+    }
+
+    /**
+     * @brief Returns an iterator at an object of the list, without searching for it.
+     *          Pre-condition: obj is in this list.
+     *          Runtime: O(1)
+     * @param obj object of the list.
+     * @return iterator at obj.
+     */
+    iterator iterator_to(T& obj) const {
+        return iterator(this, &obj);
+    }
+
+    /**
+     * @return T& the first object. Pre-condition: the list is not empty.
+     */
+    T& front() const {
+        return *head;
+    }
+
+    /**
+     * @return T& the last object. Pre-condition: the list is not empty.
+     */
+    T& back() const {
+        return *tail;
+    }
+
+    /**
+     * @return iterator at the start of the list, past the end iterator if list is empty.
+     */
+    iterator begin() const {
+        return iterator(this, head);
+    }
+
+    /**
+     * @return past the end iterator.
+     */
+    iterator end() const {
+        return iterator(this, nullptr);
+    }
+
+    private:
+        T* head;
+        T* tail;
+        int list_size;
+
+        /**
+         * @brief Links an object in right before another.
+         * @param pos object to link before, nullptr to link at the end.
+         * @param obj object to link.
+         */
+        void link(T* pos, T* obj) {
+            T* prev = pos ? (pos->*Hook).prev : tail;
+            (obj->*Hook).prev = prev;
+            (obj->*Hook).next = pos;
+            if(prev)
+                (prev->*Hook).next = obj;
+            else
+                head = obj;
+            if(pos)
+                (pos->*Hook).prev = obj;
+            else
+                tail = obj;
+            list_size++;
+        }
+
+        /**
+         * @brief Takes an object out of the list, and resets its hook.
+         * @param obj object of the list.
+         */
+        void unlink(T* obj) {
+            ListHook<T>& h = obj->*Hook;
+            if(h.prev)
+                (h.prev->*Hook).next = h.next;
+            else
+                head = h.next;
+            if(h.next)
+                (h.next->*Hook).prev = h.prev;
+            else
+                tail = h.prev;
+            h = ListHook<T>();
+            list_size--;
+        }
+};
+};
+#endif
@@ -0,0 +1,553 @@
+/**
+ * @file IntrusiveTree.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for a Scapegoat tree of objects which hold their own links.
+ * @date 2022-05-16
+ */
+
+#ifndef INTRUSIVE_TREE_H
+#define INTRUSIVE_TREE_H
+
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <utility>
+
+namespace DM852 {
+    /**
+     * @brief The links an object needs to be in an IntrusiveTree. An object can hold several hooks,
+     *          one for each tree it can be in at the same time.
+     */
+    template<typename T>
+    struct TreeHook {
+        T* parent = nullptr;
+        T* left = nullptr;
+        T* right = nullptr;
+    };
+
+    /**
+     * @brief A Scapegoat tree which links existing objects through a TreeHook member, instead of
+     *          copying them into nodes. Inserting and erasing never allocate or copy, and an object
+     *          can be found in the tree from a reference to it in O(1), see iterator_to().
+     *          The key of an object is given by KeyOf, and must not change while the object is linked.
+     *          The tree does not own the objects: they must stay alive and in place while they are linked,
+     *          and must be erased from the tree before they are destroyed.
+     *
+     *          Unlike Tree, the hook has no size and no sorted list, so it stays three pointers.
+     *          The sizes a rebalance needs are counted when it happens, which is what the original
+     *          scapegoat tree does, and a subtree is flattened before it is rebuilt.
+     *          Described in "chapter 19 scapegoat trees" by Igal Galperin and Ronald L. Rivest.
+     * @tparam T type of the objects.
+     * @tparam Hook the TreeHook<T> member of T to link through, for example &Entry::by_key.
+     * @tparam KeyOf function object which returns the key of a const T&.
+     * @tparam Comp compare function object of the keys.
+     */
+    template<typename T, TreeHook<T> T::*Hook, typename KeyOf, typename Comp = std::less<>>
+    struct IntrusiveTree {
+        using value_type = T;
+        using key_type = std::remove_cvref_t<std::invoke_result_t<KeyOf, const T&>>;
+
+        struct iterator {
+            friend struct IntrusiveTree;
+            using value_type = T;
+            using reference = value_type&;
+
+            /**
+             * @brief Default constructer.
+             */
+            iterator() : tree(nullptr), ptr(nullptr) {}
+
+            /**
+             * @brief Construct a new iterator object.
+             * @param tree the iterator belongs to.
+             * @param ptr object the iterator is at, nullptr for the past the end iterator.
+             */
+            iterator(const IntrusiveTree* tree, T* ptr) : tree(tree), ptr(ptr) {}
+
+            /**
+             * @brief Prefix increment, goes to the object with the next key.
+             *          Runtime: O(1) - amortized over a whole iteration.
+             * @return iterator& at the next object.
+             */
+            iterator& operator++() {
+                ptr = next(ptr);
+                return *this;
+            }
+
+            /**
+             * @brief Postfix increment.
+             * @return iterator at the object before the increment.
+             */
+            iterator operator++(int) {
+                iterator tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Prefix decrement. Decrementing the past the end iterator gives the last object.
+             * @return iterator& at the previous object.
+             */
+            iterator& operator--() {
+                ptr = ptr ? prev(ptr) : (tree->root ? last(tree->root) : nullptr);
+                return *this;
+            }
+
+            /**
+             * @brief Postfix decrement.
+             * @return iterator at the object before the decrement.
+             */
+            iterator operator--(int) {
+                iterator tmp = *this;
+                --*this;
+                return tmp;
+            }
+
+            /**
+             * @return reference to the object.
+             */
+            reference operator*() const {
+                return *ptr;
+            }
+
+            /**
+             * @return T* the object.
+             */
+            T* operator->() const {
+                return ptr;
+            }
+
+            bool operator==(const iterator& rhs) const {
+                return ptr == rhs.ptr;
+            }
+
+            bool operator!=(const iterator& rhs) const {
+                return ptr != rhs.ptr;
+            }
+
+            private:
+                const IntrusiveTree* tree;
+                T* ptr;
+        };
+
+        /**
+         * @brief Construct a new empty IntrusiveTree object.
+         * @param alpha balance factor, it is clamped to [0.51, 0.99], see Tree::set_alpha().
+         * @param key_of function object which gives the keys.
+         * @param compare function object for the keys.
+         */
+        explicit IntrusiveTree(float alpha = 0.57f, KeyOf key_of = KeyOf(), Comp compare = Comp())
+            : key_of(key_of), compare(compare) {
+            root = nullptr;
+            tree_size = max_size = 0;
+            this->alpha = std::clamp(alpha, 0.51f, 0.99f);
+        }
+
+        // an object can only be linked into one tree through a hook, so a tree cannot be copied
+        IntrusiveTree(const IntrusiveTree& other) = delete;
+        IntrusiveTree& operator=(const IntrusiveTree& other) = delete;
+
+        /**
+         * @brief Move Constructer. This tree takes over the objects of other, which is empty afterwards.
+         * @param other tree object.
+         */
+        IntrusiveTree(IntrusiveTree&& other)
+            : key_of(other.key_of), compare(other.compare), alpha(other.alpha) {
+            root = std::exchange(other.root, nullptr);
+            tree_size = std::exchange(other.tree_size, 0);
+            max_size = std::exchange(other.max_size, 0);
+        }
+
+        /**
+         * @brief Move Assignment operator. The objects of this tree are unlinked, and it takes over the objects of other.
+         * @param other tree object.
+         */
+        IntrusiveTree& operator=(IntrusiveTree&& other) {
+            if(this == &other) return *this;
+            clear();
+            key_of = other.key_of;
+            compare = other.compare;
+            alpha = other.alpha;
+            root = std::exchange(other.root, nullptr);
+            tree_size = std::exchange(other.tree_size, 0);
+            max_size = std::exchange(other.max_size, 0);
+            return *this;
+        }
+
+        /**
+         * @brief Unlinks the objects left in the tree. The objects themselves are not touched otherwise.
+         */
+        ~IntrusiveTree() {
+            clear();
+        }
+
+        /**
+         * @brief Return size of tree.
+         * @return int
+         */
+        int size() const {
+            return tree_size;
+        }
+
+        /**
+         * @return true if tree is empty.
+         */
+        bool empty() const {
+            return tree_size == 0;
+        }
+
+        /**
+         * @brief Links an object into the tree, if no object with the same key is in it.
+         *          If the object is too deep afterwards, the scapegoat ancestor is found by counting
+         *          the sizes on the way up, and its subtree is rebuilt.
+         *          Pre-condition: obj is not in a tree through Hook.
+         *
+         *          Runtime: O_A(log n) - amortized.
+         * @param obj object to link.
+         * @return std::pair<iterator, bool> - iterator at the object with the key, bool is true if obj was linked.
+         */
+        std::pair<iterator, bool> insert(T& obj) {
+            const key_type& key = key_of(obj);
+            T* parent = nullptr;
+            T** link = &root;
+            int depth = 0;
+            while(*link) {
+                T* n = *link;
+                if(compare(key, key_of(*n)))
+                    link = &hook(n).left;
+                else if(compare(key_of(*n), key))
+                    link = &hook(n).right;
+                else
+                    return std::make_pair(iterator(this, n), false);
+                parent = n;
+                depth++;
+            }
+            hook(&obj) = TreeHook<T>{parent, nullptr, nullptr};
+            *link = &obj;
+            tree_size++;
+            max_size = std::max(max_size, tree_size);
+            if(depth > h_alpha())
+                rebalance(&obj);
+            return std::make_pair(iterator(this, &obj), true);
+        }
+
+        /**
+         * @brief Unlinks an object from the tree. The object is not destroyed, and its hook is reset.
+         *          The whole tree is rebuilt when it has shrunk below alpha of its size since the last rebuild.
+         *          Pre-condition: obj is in this tree.
+         *
+         *          Runtime: O_A(log n) - amortized.
+         * @param obj object to unlink.
+         */
+        void erase(T& obj) {
+            T* z = &obj;
+            TreeHook<T>& hz = hook(z);
+            if(!hz.left) {
+                transplant(z, hz.right);
+            } else if(!hz.right) {
+                transplant(z, hz.left);
+            } else { // the successor takes the place of z, it is relinked and not swapped by value
+                T* y = first(hz.right);
+                if(hook(y).parent != z) {
+                    transplant(y, hook(y).right);
+                    hook(y).right = hz.right;
+                    hook(hook(y).right).parent = y;
+                }
+                transplant(z, y);
+                hook(y).left = hz.left;
+                hook(hook(y).left).parent = y;
+            }
+            hz = TreeHook<T>();
+            tree_size--;
+            if(tree_size < alpha * max_size) {
+                if(root)
+                    root = rebuild(root, tree_size, nullptr);
+                max_size = tree_size;
+            }
+        }
+
+        /**
+         * @brief Unlinks the object at pos from the tree.
+         *          Pre-condition: pos is an iterator at an object of this tree.
+         * @param pos iterator at the object.
+         * @return iterator at the object with the next key.
+         */
+        iterator erase(iterator pos) {
+            key_type key = key_of(*pos.ptr); // the tree may be rebuilt, so the next object is found again
+            erase(*pos.ptr);
+            return lower_bound(key);
+        }
+
+        /**
+         * @brief Finds the object with a key.
+         *          Runtime: O(log n)
+         * @param key to find.
+         * @return iterator at the object, past the end iterator if the key is not in the tree.
+         */
+        template<typename K>
+        iterator find(const K& key) const {
+            T* n = root;
+            while(n) {
+                if(compare(key, key_of(*n)))
+                    n = hook(n).left;
+                else if(compare(key_of(*n), key))
+                    n = hook(n).right;
+                else
+                    break;
+            }
+            return iterator(this, n);
+        }
+
+        /**
+         * @brief Finds the first object whose key is not less than key.
+         *          Runtime: O(log n)
+         * @param key to search for.
+         * @return iterator at the object, past the end iterator if every key is less.
+         */
+        template<typename K>
+        iterator lower_bound(const K& key) const {
+            T* n = root;
+            T* res = nullptr;
+            while(n) {
+                if(compare(key_of(*n), key)) {
+                    n = hook(n).right;
+                } else {
+                    res = n;
+                    n = hook(n).left;
+                }
+            }
+            return iterator(this, res);
+        }
+
+        /**
+         * @brief Returns an iterator at an object of the tree, without searching for it.
+         *          Pre-condition: obj is in this tree.
+         *          Runtime: O(1)
+         * @param obj object of the tree.
+         * @return iterator at obj.
+         */
+        iterator iterator_to(T& obj) const {
+            return iterator(this, &obj);
+        }
+
+        /**
+         * @brief Unlinks all objects, and resets their hooks.
+         *          Runtime: O(n)
+         */
+        void clear() {
+            for(T* n = root ? first(root) : nullptr; n;) {
+                T* succ = next(n); // reads the right child and the parents, which are not reset yet
+                if(!hook(n).right) { // every object on the way up to succ is done with
+                    for(T* p = n; p != succ;) {
+                        T* up = hook(p).parent;
+                        hook(p) = TreeHook<T>();
+                        p = up;
+                    }
+                }
+                n = succ;
+            }
+            root = nullptr;
+            tree_size = max_size = 0;
+        }
+
+        /**
+         * @return iterator at the object with the smallest key, past the end iterator if tree is empty.
+         */
+        iterator begin() const {
+            return iterator(this, root ? first(root) : nullptr);
+        }
+
+        /**
+         * @return past the end iterator.
+         */
+        iterator end() const {
+            return iterator(this, nullptr);
+        }
+
+        private:
+            T* root;
+            int tree_size;
+            int max_size; // biggest size since the last rebuild of the whole tree
+            KeyOf key_of;
+            Comp compare;
+            float alpha;
+
+            /**
+             * @param n object.
+             * @return TreeHook<T>& the hook of n.
+             */
+            static TreeHook<T>& hook(T* n) {
+                return n->*Hook;
+            }
+
+            /**
+             * @param n root of a subtree.
+             * @return T* the object with the smallest key in the subtree.
+             */
+            static T* first(T* n) {
+                while(hook(n).left)
+                    n = hook(n).left;
+                return n;
+            }
+
+            /**
+             * @param n root of a subtree.
+             * @return T* the object with the biggest key in the subtree.
+             */
+            static T* last(T* n) {
+                while(hook(n).right)
+                    n = hook(n).right;
+                return n;
+            }
+
+            /**
+             * @param n object of the tree.
+             * @return T* the object with the next key, nullptr if n is the last.
+             */
+            static T* next(T* n) {
+                if(hook(n).right)
+                    return first(hook(n).right);
+                T* p = hook(n).parent;
+                while(p && hook(p).right == n) {
+                    n = p;
+                    p = hook(p).parent;
+                }
+                return p;
+            }
+
+            /**
+             * @param n object of the tree.
+             * @return T* the object with the previous key, nullptr if n is the first.
+             */
+            static T* prev(T* n) {
+                if(hook(n).left)
+                    return last(hook(n).left);
+                T* p = hook(n).parent;
+                while(p && hook(p).left == n) {
+                    n = p;
+                    p = hook(p).parent;
+                }
+                return p;
+            }
+
+            /**
+             * @brief Counts the objects of a subtree.
+             *          Runtime: O(size of the subtree)
+             * @param n root of the subtree, can be nullptr.
+             * @return int
+             */
+            static int count(T* n) {
+                int res = 0;
+                while(n) { // loops down the right spine, and recurses into the left subtrees
+                    res += 1 + count(hook(n).left);
+                    n = hook(n).right;
+                }
+                return res;
+            }
+
+            /**
+             * @brief Replaces the subtree at u with the subtree at v, in the parent of u.
+             *         Described as transplant in: Introduction to Algorithms from Cormen et al. chapter 12 p.296
+             * @param u old child.
+             * @param v root of subtree to replace with, can be nullptr.
+             */
+            void transplant(T* u, T* v) {
+                T* parent = hook(u).parent;
+                if(!parent)
+                    root = v;
+                else if(hook(parent).left == u)
+                    hook(parent).left = v;
+                else
+                    hook(parent).right = v;
+                if(v)
+                    hook(v).parent = parent;
+            }
+
+            /**
+             * @brief calculates floor(log_{1/alpha}(n)), n = size of the tree.
+             * @return int
+             */
+            int h_alpha() const {
+                double base = 1 / alpha;
+                int h = 0;
+                for(double p = base; p <= tree_size; p *= base)
+                    h++;
+                return h;
+            }
+
+            /**
+             * @brief Self balancing part of insert. Walks up from an object which is too deep, counting the
+             *          subtree sizes, until a child has more than alpha of its parents size, and rebuilds the parent.
+             *          Runtime: O(size of the scapegoat)
+             * @param n the inserted object.
+             */
+            void rebalance(T* n) {
+                int n_size = 1;
+                for(T* p = hook(n).parent; p; n = p, p = hook(p).parent) {
+                    T* sibling = hook(p).left == n ? hook(p).right : hook(p).left;
+                    int p_size = n_size + count(sibling) + 1;
+                    if(n_size > alpha * p_size) {
+                        T* parent = hook(p).parent;
+                        bool left = parent && hook(parent).left == p;
+                        T* sub = rebuild(p, p_size, parent);
+                        if(!parent)
+                            root = sub;
+                        else if(left)
+                            hook(parent).left = sub;
+                        else
+                            hook(parent).right = sub;
+                        return;
+                    }
+                    n_size = p_size;
+                }
+            }
+
+            /**
+             * @brief Rebuilds a subtree perfectly balanced. It is flattened to a chain through the left
+             *          pointers first: an in order walk only reads the left pointers of objects it has not
+             *          visited yet, so the visited objects can be chained through theirs.
+             *          Runtime: O(n)
+             * @param sub root of the subtree.
+             * @param n size of the subtree.
+             * @param parent of the subtree, nullptr if it is the root.
+             * @return T* root of the rebuilt subtree, with its parent set. The caller links it into parent.
+             */
+            T* rebuild(T* sub, int n, T* parent) {
+                T* list = first(sub);
+                T* prev = list;
+                for(int i = 1; i < n; i++) {
+                    T* cur = next(prev);
+                    hook(prev).left = cur;
+                    prev = cur;
+                }
+                T* res = build(n, list);
+                hook(res).parent = parent;
+                return res;
+            }
+
+            /**
+             * @brief Builds a n-sized tree from a chain of objects linked through their left pointers.
+             *        The recursion depth is only log2(n), since the built tree is perfectly balanced.
+             *          Runtime: O(n)
+             * @param n size of tree to build
+             * @param list first object in the chain. Is moved past the used objects.
+             * @return T* root of the built tree. Its parent is set by the caller.
+             */
+            static T* build(int n, T*& list) {
+                if(n == 0)
+                    return nullptr;
+                T* l = build(n - 1 - (n-1)/2, list);
+                T* r = list;
+                list = hook(r).left;
+                hook(r).left = l;
+                if(l)
+                    hook(l).parent = r;
+                T* rr = build((n-1)/2, list);
+                hook(r).right = rr;
+                if(rr)
+                    hook(rr).parent = r;
+                return r;
+            }
+    };
+};
+#endif
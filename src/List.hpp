@@ -8,8 +8,16 @@
 #ifndef LIST_H
 #define LIST_H
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <type_traits>
 #include <utility>
 
+#include "Pool.hpp"
+
 namespace DM852 {
 template<typename T>
 struct List {
@@ -40,13 +48,6 @@ struct List {
                 prev = nullptr;
                 next = nullptr;
             }
-
-            /**
-             * @brief Destroy the Node object
-             */
-            ~Node() {
-                delete next;
-            }
         };
     public:
         struct iterator {
@@ -330,15 +331,15 @@ struct List {
          *          Runtime: O(n)
          * @param other list object.
          */
-        List(const List& other) : list_size(other.list_size) {
+        List(const List& other) : list_size(other.list_size), indexed(other.indexed) {
             if(other.head) {
-                head = new Node(other.head->data);
+                head = pool.create(other.head->data);
                 Node* tmp = head;
 
                 const_iterator iter = other.begin();
                 iter++;
                 for(;iter != other.end(); iter++) {
-                    tmp->next = new Node(*iter);
+                    tmp->next = pool.create(*iter);
                     tmp->next->prev = tmp;
                     tmp = tmp->next;
                 }
@@ -353,12 +354,14 @@ struct List {
          * @brief Move Constructer. This list takes ownership of other lists nodes.
          * @param other list object.
          */
-        List(List&& other) {
+        List(List&& other) : pool(std::move(other.pool)) {
             head = other.head;
             tail = other.tail;
             list_size = other.list_size;
+            indexed = other.indexed;
             other.head = other.tail = nullptr;
             other.list_size = 0;
+            other.index_valid = false;
         }
 
         /**
@@ -368,12 +371,16 @@ struct List {
          */
         List& operator=(List&& other) {
             if(this == &other) return *this;
-            delete head;
+            free_nodes();
+            pool = std::move(other.pool);
             head = other.head;
             tail = other.tail;
             list_size = other.list_size;
+            indexed = other.indexed;
+            index_valid = false;
             other.head = other.tail = nullptr;
             other.list_size = 0;
+            other.index_valid = false;
             return *this;
         }
 
@@ -381,7 +388,7 @@ struct List {
          * @brief Desctruct the List object.
          */
         ~List() {
-            delete head;
+            free_nodes();
         }
 
         /**
@@ -393,17 +400,21 @@ struct List {
          * @return copied List&
          */
         List& operator=(const List& other) {
-            delete head;
+            if(this == &other) return *this;
+            free_nodes(); // the blocks are kept, so the copy does not allocate unless it is bigger
             head = nullptr;
             tail = nullptr;
+            list_size = 0;
+            indexed = other.indexed;
+            index_valid = false;
             if(other.head) {
-                head = new Node(other.head->data);
+                head = pool.create(other.head->data);
                 Node* tmp = head;
 
                 const_iterator iter = other.begin();
                 iter++;
                 for(;iter != other.end(); iter++) {
-                    tmp->next = new Node(*iter);
+                    tmp->next = pool.create(*iter);
                     tmp->next->prev = tmp;
                     tmp = tmp->next;
                 }
@@ -454,16 +465,18 @@ struct List {
          * @param elem value_type to insert.
          */
         void push_back(const value_type& elem) {
-            Node* node = new Node(elem);
+            Node* node = pool.create(elem);
             list_size++;
             if(head == nullptr) { //empty list
                 head = node;
                 tail = node;
-                return;
+            } else {
+                node->prev = tail;
+                tail->next = node;
+                tail = node;
             }
-            node->prev = tail;
-            tail->next = node;
-            tail = node;
+            if(index_valid)
+                index_insert(list_size - 1, node);
         }
 
         /**
@@ -471,16 +484,18 @@ struct List {
          * @param elem rvalue value_type to insert by moving.
          */
         void push_back(value_type&& elem) {
-            Node* node = new Node(elem);
+            Node* node = pool.create(elem);
             list_size++;
             if(head == nullptr) { //empty list
                 head = node;
                 tail = node;
-                return;
+            } else {
+                node->prev = tail;
+                tail->next = node;
+                tail = node;
             }
-            node->prev = tail;
-            tail->next = node;
-            tail = node;
+            if(index_valid)
+                index_insert(list_size - 1, node);
         }
 
         /**
@@ -495,7 +510,7 @@ struct List {
         iterator insert(const_iterator pos, const value_type& elem) {
             Node* prev = pos.ptr ? pos.ptr->prev : tail;
             Node* next = pos.ptr ? pos.ptr : nullptr;
-            Node* newNode = new Node(elem);
+            Node* newNode = pool.create(elem);
 
             if(pos == begin()) // head
                 head = newNode;
@@ -508,6 +523,7 @@ struct List {
             newNode->next = next;
             newNode->prev = prev;
             list_size++;
+            index_valid = false; // the position of pos is not known
 
             return iterator(*this, newNode);
         }
@@ -524,7 +540,7 @@ struct List {
         iterator insert(const_iterator pos, value_type&& elem) {
             Node* prev = pos.ptr ? pos.ptr->prev : tail;
             Node* next = pos.ptr ? pos.ptr : nullptr;
-            Node* newNode = new Node(elem);
+            Node* newNode = pool.create(elem);
 
             if(pos == begin()) // head
                 head = newNode;
@@ -537,21 +553,23 @@ struct List {
             newNode->next = next;
             newNode->prev = prev;
             list_size++;
+            index_valid = false; // the position of pos is not known
 
             return iterator(*this, newNode);
         }
 
         /**
-         * @brief Removes the whole list by deleting all nodes starting from the head.
+         * @brief Removes the whole list by destroying all nodes starting from the head.
+         *          The memory blocks of the nodes are kept, so the list can be refilled without allocating.
          *
-         *          If memory de-allocation runtime should be counted:
-         *          Runtime: O(n)
+         *          Runtime: O(n), O(1) if T is trivially destructible.
          */
         void clear() {
-            delete head;
+            free_nodes();
             head = nullptr;
             tail = nullptr;
             list_size = 0;
+            index_valid = false;
         }
 
         /**
@@ -560,14 +578,16 @@ struct List {
          */
         void pop_back() {
             if(tail) {
+                if(index_valid)
+                    index_erase(list_size - 1);
                 if(tail == head) { // only one element
                     head = nullptr;
-                    delete tail;
+                    pool.destroy(tail);
                     tail = nullptr;
                 } else {
                     Node* tmp = tail->prev;
                     tail->prev->next = nullptr;
-                    delete tail;
+                    pool.destroy(tail);
                     tail = tmp;
                 }
                 list_size--;
@@ -580,7 +600,7 @@ struct List {
          */
         void erase(const_iterator pos) {
             Node* tmp = pos.ptr->prev;
-            Node* tmp2 = tmp->next;
+            Node* tmp2 = pos.ptr;
             if(pos == begin())
                 head = pos.ptr->next;
             else
@@ -589,9 +609,287 @@ struct List {
                 tail = tmp;
             else
                 pos.ptr->next->prev = tmp;
-            tmp2->next = tmp2->prev = nullptr; // set these to null, so only the node is deleted and not the next.
             list_size--;
-            delete tmp2;
+            index_valid = false;
+            pool.destroy(tmp2);
+        }
+
+        /**
+         * @brief Turns the position index on or off. The index is an indexable skip list on top of the list:
+         *          about every 4th node gets a tower of links which skip ahead, and every link knows how many nodes it skips,
+         *          so a position is found in O(log n) instead of walking the list.
+         *          The index is kept up to date by the positional functions, push_back() and pop_back(). Every other change,
+         *          like insert(), erase(), splice() or sort(), only marks it as stale, and it is rebuilt in O(n) by the next positional call.
+         *          Without the index the positional functions walk from the nearer end of the list.
+         *          A stale index is also rebuilt by the const iterator_at() and at(), so unlike the other const functions
+         *          they must not be called from several threads at once while the index is stale.
+         *
+         *          Runtime: O(1), the index is built when it is first used.
+         * @param on true to keep an index.
+         */
+        void set_indexed(bool on) {
+            indexed = on;
+            index_valid = false;
+            if(!on)
+                levels.release();
+        }
+
+        /**
+         * @return true if the list keeps a position index.
+         */
+        bool is_indexed() const {
+            return indexed;
+        }
+
+        /**
+         * @brief Finds the element at position i, counted from 0.
+         *
+         *          Runtime: O(log n) expected with the index, else O(min(i, n - i)).
+         * @param i position of the element.
+         * @return iterator at the element, past the end iterator if i is not in [0, size()).
+         */
+        iterator iterator_at(int i) {
+            return iterator(*this, node_at(i));
+        }
+
+        /**
+         * @brief Finds the element at position i, counted from 0.
+         *          Not thread-safe with the index on: a stale index is rebuilt here, see set_indexed().
+         *
+         *          Runtime: O(log n) expected with the index, else O(min(i, n - i)).
+         * @param i position of the element.
+         * @return const_iterator at the element, past the end const_iterator if i is not in [0, size()).
+         */
+        const_iterator iterator_at(int i) const {
+            return const_iterator(*this, node_at(i));
+        }
+
+        /**
+         * @brief Returns the element at position i, counted from 0.
+         *          Pre-condition: 0 <= i < size().
+         *
+         *          Runtime: O(log n) expected with the index, else O(min(i, n - i)).
+         * @param i position of the element.
+         * @return value_type& the element.
+         */
+        value_type& at(int i) {
+            return node_at(i)->data;
+        }
+
+        /**
+         * @brief Returns the element at position i, counted from 0.
+         *          Pre-condition: 0 <= i < size().
+         *          Not thread-safe with the index on: a stale index is rebuilt here, see set_indexed().
+         *
+         *          Runtime: O(log n) expected with the index, else O(min(i, n - i)).
+         * @param i position of the element.
+         * @return const value_type& the element.
+         */
+        const value_type& at(int i) const {
+            return node_at(i)->data;
+        }
+
+        /**
+         * @brief Inserts an element so it gets position i, the element at i and all after it move one position back.
+         *          Unlike insert(), this keeps the index up to date.
+         *          Pre-condition: 0 <= i <= size().
+         *
+         *          Runtime: O(log n) expected with the index, else O(min(i, n - i)).
+         * @param i position of the new element.
+         * @param elem value_type to insert.
+         * @return iterator at the new element.
+         */
+        iterator insert_at(int i, const value_type& elem) {
+            return iterator(*this, insert_node(i, pool.create(elem)));
+        }
+
+        /**
+         * @brief Overloaded insert_at(), by moving.
+         *          Pre-condition: 0 <= i <= size().
+         * @param i position of the new element.
+         * @param elem rvalue value_type to insert by moving.
+         * @return iterator at the new element.
+         */
+        iterator insert_at(int i, value_type&& elem) {
+            return iterator(*this, insert_node(i, pool.create(std::move(elem))));
+        }
+
+        /**
+         * @brief Removes the element at position i. Unlike erase(), this keeps the index up to date.
+         *          Pre-condition: 0 <= i < size().
+         *
+         *          Runtime: O(log n) expected with the index, else O(min(i, n - i)).
+         * @param i position of the element to remove.
+         */
+        void erase_at(int i) {
+            Node* node;
+            if(indexed) {
+                if(!index_valid)
+                    rebuild_index();
+                node = index_erase(i);
+            } else {
+                node = node_at(i);
+            }
+            unlink_range(node, node);
+            list_size--;
+            pool.destroy(node);
+        }
+
+        /**
+         * @brief Moves all elements of other into this list, right before pos. The nodes are relinked, not copied.
+         *          The memory of other is taken over by this pool, since the nodes live in it. other is empty afterwards,
+         *          and iterators to its elements now point into this list.
+         *          Pre-condition: The const_iterator pos must be an iterator of this list.
+         *
+         *          Runtime: O(1), plus O(b + f) to take over the b blocks and f free slots of the other pool.
+         * @param pos const_iterator at the position to insert.
+         * @param other list to take the elements from.
+         */
+        void splice(const_iterator pos, List& other) {
+            if(this == &other || other.empty()) return;
+            pool.splice(other.pool);
+            link_range(pos.ptr, other.head, other.tail);
+            list_size += other.list_size;
+            index_valid = false;
+            other.head = other.tail = nullptr;
+            other.list_size = 0;
+            other.index_valid = false;
+        }
+
+        /**
+         * @brief Overloaded splice(), for a temporary list.
+         * @param pos const_iterator at the position to insert.
+         * @param other list to take the elements from.
+         */
+        void splice(const_iterator pos, List&& other) {
+            splice(pos, other);
+        }
+
+        /**
+         * @brief Moves one element of other right before pos.
+         *          In the same list the node is relinked. From another list the element is moved
+         *          into a new node of this pool, since every list has its own pool, and it is erased from other.
+         *          Pre-condition: pos is an iterator of this list, and it is an iterator at an element of other.
+         *
+         *          Runtime: O(1)
+         * @param pos const_iterator at the position to insert.
+         * @param other list which it belongs to.
+         * @param it const_iterator at the element to move.
+         */
+        void splice(const_iterator pos, List& other, const_iterator it) {
+            if(this == &other) {
+                if(pos.ptr == it.ptr || pos.ptr == it.ptr->next) return; // already in place
+                unlink_range(it.ptr, it.ptr);
+                link_range(pos.ptr, it.ptr, it.ptr);
+                index_valid = false;
+                return;
+            }
+            insert(pos, std::move(it.ptr->data));
+            other.erase(it);
+        }
+
+        /**
+         * @brief Moves the elements [first, last) of other right before pos, in the same order.
+         *          In the same list the nodes are relinked. From another list the whole list is relinked as in splice(pos, other),
+         *          and a part of it is moved into new nodes of this pool, one element at a time.
+         *          Pre-condition: pos is an iterator of this list, which is not in [first, last) if other is this list,
+         *          and [first, last) is a range of other.
+         *
+         *          Runtime: O(1) in the same list or for all of other, else O(k), k is the number of elements.
+         * @param pos const_iterator at the position to insert.
+         * @param other list which the range belongs to.
+         * @param first const_iterator at the first element to move.
+         * @param last const_iterator after the last element to move.
+         */
+        void splice(const_iterator pos, List& other, const_iterator first, const_iterator last) {
+            if(first == last) return;
+            if(this == &other) {
+                if(pos.ptr == last.ptr) return; // already in place
+                Node* l = last.ptr ? last.ptr->prev : tail;
+                unlink_range(first.ptr, l);
+                link_range(pos.ptr, first.ptr, l);
+                index_valid = false;
+                return;
+            }
+            if(first.ptr == other.head && last.ptr == nullptr) {
+                splice(pos, other);
+                return;
+            }
+            for(Node* n = first.ptr; n != last.ptr;) {
+                Node* next = n->next;
+                splice(pos, other, const_iterator(other, n));
+                n = next;
+            }
+        }
+
+        /**
+         * @brief Merges the sorted list other into this sorted list, by relinking the nodes. Both lists must be sorted by comp.
+         *          Equal elements of this list come before those of other, so the merge is stable.
+         *          The memory of other is taken over by this pool, and other is empty afterwards.
+         *
+         *          Runtime: O(n + m), and no element is copied or allocated.
+         * @param other sorted list to take the elements from.
+         * @param comp compare function, the same as the lists are sorted by.
+         */
+        template<typename Comp = std::less<T>>
+        void merge(List& other, Comp comp = Comp()) {
+            if(this == &other || other.empty()) return;
+            pool.splice(other.pool);
+            if(tail) // the merge uses the next pointers only
+                tail->next = nullptr;
+            head = merge_runs(head, other.head, comp);
+            list_size += other.list_size;
+            index_valid = false;
+            other.head = other.tail = nullptr;
+            other.list_size = 0;
+            other.index_valid = false;
+            relink_prev();
+        }
+
+        /**
+         * @brief Overloaded merge(), for a temporary list.
+         * @param other sorted list to take the elements from.
+         * @param comp compare function, the same as the lists are sorted by.
+         */
+        template<typename Comp = std::less<T>>
+        void merge(List&& other, Comp comp = Comp()) {
+            merge(other, comp);
+        }
+
+        /**
+         * @brief Sorts the list with a merge sort which relinks the nodes, so nothing is copied or allocated,
+         *          and iterators stay at their elements. The sort is stable.
+         *          Sorted runs of length 1, 2, 4, ... are kept in an array like the digits of a binary counter,
+         *          and every node is merged in as a new run of length 1, so no list has to be split or counted.
+         *
+         *          Runtime: O(n log n)
+         * @param comp compare function.
+         */
+        template<typename Comp = std::less<T>>
+        void sort(Comp comp = Comp()) {
+            if(list_size < 2) return;
+            Node* runs[64] = {}; // runs[i] has 2^i nodes or is empty
+            int used = 0;
+            Node* n = head;
+            while(n) {
+                Node* carry = n;
+                n = n->next;
+                carry->next = nullptr;
+                int i = 0;
+                for(; i < used && runs[i]; i++) { // the earlier run goes first, which keeps it stable
+                    carry = merge_runs(runs[i], carry, comp);
+                    runs[i] = nullptr;
+                }
+                runs[i] = carry;
+                used = std::max(used, i + 1);
+            }
+            Node* res = nullptr;
+            for(int i = 0; i < used; i++)
+                if(runs[i])
+                    res = res ? merge_runs(runs[i], res, comp) : runs[i];
+            head = res;
+            relink_prev();
+            index_valid = false;
         }
 
         /**
@@ -671,6 +969,295 @@ struct List {
         int list_size;
         Node* head;
         Node* tail;
+        Pool<Node> pool; // all nodes of the list are created in here
+
+        /**
+         * @brief A link of the position index. The links of one node form a tower from level 0 upwards.
+         *          Every level is a chain in list order, which starts at a header with node == nullptr at position -1.
+         */
+        struct Level {
+            Level* right; // next link on the same level
+            Level* down;  // link of the same node one level lower, nullptr on level 0
+            Node* node;
+            int width;    // number of positions from this link to right, unused if right is nullptr
+        };
+
+        static constexpr int max_level = 15; // every level has 1/4 of the links of the one below, enough for 2^30 nodes
+
+        bool indexed = false;
+        // the index is built lazily, also by the const positional functions, so it is mutable
+        mutable bool index_valid = false;
+        mutable Level* top = nullptr; // header of the highest level
+        mutable Pool<Level> levels;
+        mutable std::uint32_t seed = 0x9E3779B9u;
+
+        /**
+         * @brief Destroys every node of the list, and gives their memory back to the pool.
+         *          Does not reset head, tail or the size.
+         *
+         *          Runtime: O(n), O(1) if T is trivially destructible.
+         */
+        void free_nodes() {
+            if constexpr(!std::is_trivially_destructible_v<T>) {
+                for(Node* n = head; n;) {
+                    Node* next = n->next;
+                    std::destroy_at(n);
+                    n = next;
+                }
+            }
+            pool.reset();
+        }
+
+        /**
+         * @brief Finds the node at position i.
+         * @param i position of the node.
+         * @return Node* at position i, nullptr if i is not in [0, size()).
+         */
+        Node* node_at(int i) const {
+            if(i < 0 || i >= list_size) return nullptr;
+            if(indexed) {
+                if(!index_valid)
+                    rebuild_index();
+                Level* update[max_level];
+                int pos[max_level];
+                search(i, update, pos);
+                return walk(update[0], pos[0], i);
+            }
+            Node* n;
+            if(i < list_size / 2) {
+                n = head;
+                for(int k = 0; k < i; k++)
+                    n = n->next;
+            } else { // the back half is closer from the tail
+                n = tail;
+                for(int k = list_size - 1; k > i; k--)
+                    n = n->prev;
+            }
+            return n;
+        }
+
+        /**
+         * @brief Links a node in at position i, and adds it to the index.
+         * @param i position of the node.
+         * @param node created by the pool, but not linked.
+         * @return Node* the node.
+         */
+        Node* insert_node(int i, Node* node) {
+            if(indexed && !index_valid)
+                rebuild_index();
+            link_range(i == list_size ? nullptr : node_at(i), node, node);
+            list_size++;
+            if(index_valid)
+                index_insert(i, node);
+            return node;
+        }
+
+        /**
+         * @brief Finds the last link before position i on every level of the index.
+         * @param i position to search for.
+         * @param update gets the last link before i of every level.
+         * @param pos gets the positions of the links in update.
+         */
+        void search(int i, Level** update, int* pos) const {
+            Level* x = top;
+            int p = -1;
+            for(int l = max_level - 1; l >= 0; l--) {
+                while(x->right && p + x->width < i) {
+                    p += x->width;
+                    x = x->right;
+                }
+                update[l] = x;
+                pos[l] = p;
+                x = x->down;
+            }
+        }
+
+        /**
+         * @brief Walks the list from a link of the index to position i.
+         * @param x link of level 0 at a position before i.
+         * @param p position of x.
+         * @param i position to walk to.
+         * @return Node* at position i.
+         */
+        Node* walk(const Level* x, int p, int i) const {
+            Node* n = x->node ? x->node : head;
+            for(int k = x->node ? p : 0; k < i; k++)
+                n = n->next;
+            return n;
+        }
+
+        /**
+         * @brief Adds a node, which was just linked in at position i, to the index.
+         *          It gets a tower of random height, and the links which jump over it get one wider.
+         * @param i position of the node.
+         * @param node the new node.
+         */
+        void index_insert(int i, Node* node) const {
+            Level* update[max_level];
+            int pos[max_level];
+            search(i, update, pos);
+            int h = random_height();
+            Level* below = nullptr;
+            for(int l = 0; l < max_level; l++) {
+                Level* u = update[l];
+                if(l < h) {
+                    Level* x = levels.create();
+                    x->node = node;
+                    x->down = below;
+                    x->right = u->right;
+                    x->width = u->right ? pos[l] + u->width + 1 - i : 0;
+                    u->right = x;
+                    u->width = i - pos[l];
+                    below = x;
+                } else if(u->right) {
+                    u->width++;
+                }
+            }
+        }
+
+        /**
+         * @brief Removes the node at position i from the index. The node stays in the list.
+         * @param i position of the node.
+         * @return Node* at position i.
+         */
+        Node* index_erase(int i) const {
+            Level* update[max_level];
+            int pos[max_level];
+            search(i, update, pos);
+            Node* node = walk(update[0], pos[0], i);
+            for(int l = 0; l < max_level; l++) {
+                Level* u = update[l];
+                Level* r = u->right;
+                if(r && r->node == node) {
+                    u->width = r->right ? u->width + r->width - 1 : 0;
+                    u->right = r->right;
+                    levels.destroy(r);
+                } else if(r) {
+                    u->width--;
+                }
+            }
+            return node;
+        }
+
+        /**
+         * @brief Builds the index from scratch, in one pass over the list.
+         *
+         *          Runtime: O(n)
+         */
+        void rebuild_index() const {
+            levels.reset(); // links are trivially destructible
+            Level* last[max_level]; // last link of every level so far
+            int last_pos[max_level];
+            Level* below = nullptr;
+            for(int l = 0; l < max_level; l++) {
+                last[l] = levels.create();
+                last[l]->down = below;
+                last_pos[l] = -1;
+                below = last[l];
+            }
+            top = below;
+            int i = 0;
+            for(Node* n = head; n; n = n->next, i++) {
+                int h = random_height();
+                below = nullptr;
+                for(int l = 0; l < h; l++) {
+                    Level* x = levels.create();
+                    x->node = n;
+                    x->down = below;
+                    last[l]->right = x;
+                    last[l]->width = i - last_pos[l];
+                    last[l] = x;
+                    last_pos[l] = i;
+                    below = x;
+                }
+            }
+            index_valid = true;
+        }
+
+        /**
+         * @brief Draws the height of a new tower from a xorshift generator. A tower reaches level l with probability 4^-(l+1).
+         * @return int height in [0, max_level].
+         */
+        int random_height() const {
+            seed ^= seed << 13;
+            seed ^= seed >> 17;
+            seed ^= seed << 5;
+            return std::min(std::countr_zero(seed | (1u << 31)) / 2, max_level);
+        }
+
+        /**
+         * @brief Links the chain of nodes from f to l right before a node.
+         * @param pos node to link before, nullptr to link at the end.
+         * @param f first node of the chain.
+         * @param l last node of the chain.
+         */
+        void link_range(Node* pos, Node* f, Node* l) {
+            Node* prev = pos ? pos->prev : tail;
+            f->prev = prev;
+            l->next = pos;
+            if(prev)
+                prev->next = f;
+            else
+                head = f;
+            if(pos)
+                pos->prev = l;
+            else
+                tail = l;
+        }
+
+        /**
+         * @brief Takes the chain of nodes from f to l out of the list, without destroying them.
+         * @param f first node of the chain.
+         * @param l last node of the chain.
+         */
+        void unlink_range(Node* f, Node* l) {
+            if(f->prev)
+                f->prev->next = l->next;
+            else
+                head = l->next;
+            if(l->next)
+                l->next->prev = f->prev;
+            else
+                tail = f->prev;
+        }
+
+        /**
+         * @brief Merges two sorted chains which are linked by their next pointers only.
+         *          On equal elements the node of a comes first.
+         * @param a first chain, ends with nullptr.
+         * @param b second chain, ends with nullptr.
+         * @param comp compare function.
+         * @return Node* first node of the merged chain.
+         */
+        template<typename Comp>
+        static Node* merge_runs(Node* a, Node* b, Comp& comp) {
+            Node* res = nullptr;
+            Node** link = &res; // the next pointer to set
+            while(a && b) {
+                if(comp(b->data, a->data)) {
+                    *link = b;
+                    b = b->next;
+                } else {
+                    *link = a;
+                    a = a->next;
+                }
+                link = &(*link)->next;
+            }
+            *link = a ? a : b;
+            return res;
+        }
+
+        /**
+         * @brief Sets the prev pointers and the tail from the next pointers, after a merge.
+         */
+        void relink_prev() {
+            Node* prev = nullptr;
+            for(Node* n = head; n; n = n->next) {
+                n->prev = prev;
+                prev = n;
+            }
+            tail = prev;
+        }
     };
 };
 #endif
\ No newline at end of file
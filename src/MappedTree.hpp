@@ -0,0 +1,388 @@
+/**
+ * @file MappedTree.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for a read only sorted map which is served from a memory mapped file.
+ * @date 2022-05-16
+ */
+
+#ifndef MAPPED_TREE_H
+#define MAPPED_TREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Serialize.hpp"
+
+namespace DM852 {
+    /**
+     * @brief A read only sorted map on top of a file written by write_binary() from a Tree with
+     *          trivially copyable keys and values. The file is mapped into memory, and find() and iteration
+     *          read the runs of the file in place, so opening the map costs O(1) no matter its size,
+     *          and only the pages that are used are read from disk.
+     *          A search does a binary search over the first keys of the runs, and then one in a run.
+     *          Uses POSIX mmap().
+     * @tparam Key type of the keys.
+     * @tparam Value type of the values.
+     * @tparam Comp compare function object of the keys, the same the Tree was sorted by.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    struct MappedTree {
+        static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+            "only trivially copyable keys and values are stored as their bytes");
+        static_assert(alignof(Key) <= BinaryHeader::alignment && alignof(Value) <= BinaryHeader::alignment);
+        // run_size is 32 bits, so this bounds the size of a run far below 2^64 for any header
+        static_assert(sizeof(Key) + sizeof(Value) < (std::uint64_t(1) << 30), "a run must not overflow 64 bits");
+
+        using value_type = std::pair<const Key&, const Value&>;
+
+        struct const_iterator {
+            friend struct MappedTree;
+            using value_type = MappedTree::value_type;
+
+            /**
+             * @brief Default constructer.
+             */
+            const_iterator() : tree(nullptr), i(0) {}
+
+            /**
+             * @brief Construct a new const_iterator object.
+             * @param tree the iterator belongs to.
+             * @param i position of the pair.
+             */
+            const_iterator(const MappedTree* tree, std::uint64_t i) : tree(tree), i(i) {}
+
+            const_iterator& operator++() {
+                i++;
+                return *this;
+            }
+
+            const_iterator operator++(int) {
+                const_iterator tmp = *this;
+                i++;
+                return tmp;
+            }
+
+            const_iterator& operator--() {
+                i--;
+                return *this;
+            }
+
+            const_iterator operator--(int) {
+                const_iterator tmp = *this;
+                i--;
+                return tmp;
+            }
+
+            /**
+             * @return value_type references to the key and value in the file.
+             */
+            value_type operator*() const {
+                return value_type(tree->key_at(i), tree->value_at(i));
+            }
+
+            /**
+             * @brief Holds the pair of references, so it can be used with ->.
+             */
+            struct Arrow {
+                value_type pair;
+                const value_type* operator->() const { return &pair; }
+            };
+
+            Arrow operator->() const {
+                return Arrow{**this};
+            }
+
+            bool operator==(const const_iterator& rhs) const {
+                return i == rhs.i;
+            }
+
+            bool operator!=(const const_iterator& rhs) const {
+                return i != rhs.i;
+            }
+
+            private:
+                const MappedTree* tree;
+                std::uint64_t i;
+        };
+
+        /**
+         * @brief Construct a new MappedTree object with no file.
+         * @param compare Comp object.
+         */
+        explicit MappedTree(Comp compare = Comp()) : comp(compare) {}
+
+        /**
+         * @brief Construct a new MappedTree object, and opens a file. See open().
+         * @param path of the file.
+         * @param compare Comp object.
+         */
+        explicit MappedTree(const std::string& path, Comp compare = Comp()) : comp(compare) {
+            open(path);
+        }
+
+        MappedTree(const MappedTree& other) = delete;
+        MappedTree& operator=(const MappedTree& other) = delete;
+
+        /**
+         * @brief Move Constructer. This map takes over the mapping of other.
+         * @param other map object.
+         */
+        MappedTree(MappedTree&& other) : comp(other.comp) {
+            take(other);
+        }
+
+        /**
+         * @brief Move Assignment operator. The file of this map is unmapped, and it takes over the mapping of other.
+         * @param other map object.
+         */
+        MappedTree& operator=(MappedTree&& other) {
+            if(this == &other) return *this;
+            close();
+            comp = other.comp;
+            take(other);
+            return *this;
+        }
+
+        /**
+         * @brief Unmaps the file.
+         */
+        ~MappedTree() {
+            close();
+        }
+
+        /**
+         * @brief Maps a file, in place of the one mapped before.
+         *          The file must not be changed while it is mapped.
+         *
+         *          Runtime: O(1)
+         * @param path of the file.
+         * @return true if the file could be mapped, and it holds a tree of these types which is as long as its header says.
+         */
+        bool open(const std::string& path) {
+            close();
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if(fd < 0)
+                return false;
+            struct stat st;
+            bool ok = ::fstat(fd, &st) == 0 && std::uint64_t(st.st_size) >= sizeof(BinaryHeader);
+            if(ok) {
+                void* m = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+                ok = m != MAP_FAILED;
+                if(ok) {
+                    base = static_cast<const char*>(m);
+                    length = st.st_size;
+                }
+            }
+            ::close(fd); // the mapping stays valid without the file descriptor
+            if(!ok)
+                return false;
+            std::memcpy(&header, base, sizeof(header));
+            run_bytes = BinaryHeader::padded(std::uint64_t(header.run_size) * sizeof(Key)) +
+                        BinaryHeader::padded(std::uint64_t(header.run_size) * sizeof(Value));
+            if(!header.matches(BinaryHeader::tree_magic, true, sizeof(Key), sizeof(Value)) || !fits()) {
+                close();
+                return false;
+            }
+            runs = (header.count + header.run_size - 1) / header.run_size;
+            return true;
+        }
+
+        /**
+         * @brief Unmaps the file. The map is empty afterwards.
+         */
+        void close() {
+            if(base)
+                ::munmap(const_cast<char*>(base), length);
+            base = nullptr;
+            length = 0;
+            header = BinaryHeader();
+            runs = 0;
+        }
+
+        /**
+         * @return true if a file is mapped.
+         */
+        bool is_open() const {
+            return base != nullptr;
+        }
+
+        /**
+         * @brief Return number of pairs.
+         * @return std::uint64_t
+         */
+        std::uint64_t size() const {
+            return header.count;
+        }
+
+        /**
+         * @return true if there are no pairs.
+         */
+        bool empty() const {
+            return header.count == 0;
+        }
+
+        /**
+         * @param i position of a pair, in [0, size()).
+         * @return const Key& the key of the pair in the file.
+         */
+        const Key& key_at(std::uint64_t i) const {
+            return run_keys(i / header.run_size)[i % header.run_size];
+        }
+
+        /**
+         * @param i position of a pair, in [0, size()).
+         * @return const Value& the value of the pair in the file.
+         */
+        const Value& value_at(std::uint64_t i) const {
+            return run_values(i / header.run_size)[i % header.run_size];
+        }
+
+        /**
+         * @brief Finds a pair given a key.
+         *          Runtime: O(log n)
+         * @param key to find
+         * @return const_iterator at the position of the pair. past the end iterator if not found.
+         */
+        const_iterator find(const Key& key) const {
+            const_iterator it = lower_bound(key);
+            if(it != end() && !comp(key, key_at(it.i)))
+                return it;
+            return end();
+        }
+
+        /**
+         * @brief Finds the first pair whose key is not smaller than key.
+         *          Runtime: O(log n)
+         * @param key to search for.
+         * @return const_iterator at the position of the pair. past the end iterator if there is none.
+         */
+        const_iterator lower_bound(const Key& key) const {
+            return const_iterator(this, search(key, false));
+        }
+
+        /**
+         * @brief Finds the first pair whose key is bigger than key.
+         *          Runtime: O(log n)
+         * @param key to search for.
+         * @return const_iterator at the position of the pair. past the end iterator if there is none.
+         */
+        const_iterator upper_bound(const Key& key) const {
+            return const_iterator(this, search(key, true));
+        }
+
+        /**
+         * @return const_iterator at the position of the smallest pair.
+         */
+        const_iterator begin() const {
+            return const_iterator(this, 0);
+        }
+
+        /**
+         * @return past the end const_iterator.
+         */
+        const_iterator end() const {
+            return const_iterator(this, header.count);
+        }
+
+        private:
+            const char* base = nullptr;
+            std::uint64_t length = 0;
+            BinaryHeader header;
+            std::uint64_t run_bytes = 0; // size of a full run
+            std::uint64_t runs = 0;
+            Comp comp;
+
+            /**
+             * @brief Takes over the mapping of another map, which is left with none.
+             * @param other map object.
+             */
+            void take(MappedTree& other) {
+                base = std::exchange(other.base, nullptr);
+                length = std::exchange(other.length, 0);
+                header = std::exchange(other.header, BinaryHeader());
+                run_bytes = other.run_bytes;
+                runs = std::exchange(other.runs, 0);
+            }
+
+            /**
+             * @param r run number.
+             * @return std::uint64_t number of pairs in the run, only the last run can be shorter.
+             */
+            std::uint64_t run_count(std::uint64_t r) const {
+                return std::min<std::uint64_t>(header.run_size, header.count - r * header.run_size);
+            }
+
+            /**
+             * @brief Checks that the file is as long as the header says. The runs are counted against the bytes
+             *          after the header by division, so a corrupt count cannot make the size wrap around.
+             *          Pre-condition: the header matches, so run_size > 0.
+             * @return true if the file holds all runs of the header.
+             */
+            bool fits() const {
+                std::uint64_t room = length - sizeof(BinaryHeader);
+                std::uint64_t full = header.count / header.run_size;
+                std::uint64_t rest = header.count % header.run_size;
+                if(full > room / run_bytes)
+                    return false;
+                room -= full * run_bytes;
+                return BinaryHeader::padded(rest * sizeof(Key)) + BinaryHeader::padded(rest * sizeof(Value)) <= room;
+            }
+
+            /**
+             * @param r run number.
+             * @return const Key* the keys of the run.
+             */
+            const Key* run_keys(std::uint64_t r) const {
+                return reinterpret_cast<const Key*>(base + sizeof(BinaryHeader) + r * run_bytes);
+            }
+
+            /**
+             * @param r run number.
+             * @return const Value* the values of the run, right after its padded keys.
+             */
+            const Value* run_values(std::uint64_t r) const {
+                const char* keys = reinterpret_cast<const char*>(run_keys(r));
+                return reinterpret_cast<const Value*>(keys + BinaryHeader::padded(run_count(r) * sizeof(Key)));
+            }
+
+            /**
+             * @brief Finds the run the bound is in by the first keys of the runs, and then the bound in the run.
+             *          If the bound is past the end of that run, it is the first pair of the next run.
+             *          Runtime: O(log n)
+             *
+             * @param key to search for.
+             * @param upper if true, find the first key bigger than key, else the first key not smaller.
+             * @return std::uint64_t position of the result, size() if there is none.
+             */
+            std::uint64_t search(const Key& key, bool upper) const {
+                // the first run whose first key is bigger than key (or not smaller if not upper)
+                std::uint64_t lo = 0, hi = runs;
+                while(lo < hi) {
+                    std::uint64_t mid = lo + (hi - lo) / 2;
+                    const Key& first = run_keys(mid)[0];
+                    if(upper ? comp(key, first) : !comp(first, key))
+                        hi = mid;
+                    else
+                        lo = mid + 1;
+                }
+                if(lo == 0)
+                    return 0;
+                std::uint64_t r = lo - 1;
+                const Key* keys = run_keys(r);
+                const Key* last = keys + run_count(r);
+                const Key* it = upper ? std::upper_bound(keys, last, key, comp) : std::lower_bound(keys, last, key, comp);
+                return r * header.run_size + (it - keys);
+            }
+    };
+};
+#endif
@@ -0,0 +1,590 @@
+/**
+ * @file PersistentTree.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for a persistent Scapegoat tree, where snapshots share their nodes.
+ * @date 2022-05-16
+ */
+
+#ifndef PERSISTENT_TREE_H
+#define PERSISTENT_TREE_H
+
+#include <math.h>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+namespace DM852 {
+    /**
+     * @brief A scapegoat tree with O(1) snapshots.
+     *          The nodes are reference counted and shared between a tree and its snapshots.
+     *          A node which is shared is never changed: an update copies the shared nodes on the path
+     *          it changes (path copying), and the copies point to the same children as the originals.
+     *          A node which is only reachable from this tree is changed in place, so a tree without
+     *          snapshots does not copy anything.
+     *          A scapegoat rebuild makes new nodes for the scapegoat subtree only.
+     *
+     *          The reference counts are atomic, so snapshots can be read and destroyed by other
+     *          threads while this tree is changed. A single tree object must still only be used by one thread at a time.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    struct PersistentTree {
+        using value_type = std::pair<const Key, Value>;
+    private:
+        /**
+         * @brief Nested Node class
+         */
+        struct Node {
+            Node* left;
+            Node* right;
+            value_type pair;
+            int size; // number of nodes in the subtree rooted at this node
+            std::atomic<int> refs; // number of parents and trees which point to the node
+
+            /**
+             * @brief Construct a new Node object, and stores the key and value in the node.
+             * @param key key of the node
+             * @param value value of the node
+             */
+            Node(const Key& key, const Value& value) : pair(key, value) {
+                left = right = nullptr;
+                size = 1;
+                refs = 1;
+            }
+        };
+    public:
+        /**
+         * @brief Forward iterator over one version of the tree.
+         *          Keeps a stack of the nodes whose left subtree has been visited, since the nodes have no
+         *          parent pointers. Changing the tree may free its unshared nodes, which invalidates the
+         *          iterators of the tree, but not the iterators of its snapshots.
+         */
+        struct const_iterator {
+            friend class PersistentTree;
+            using iterator_category = std::forward_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = std::pair<const Key, Value>;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            /**
+             * @brief Default constructer, the past the end iterator.
+             */
+            const_iterator() = default;
+
+            /**
+             * @brief dereference operator overloaded.
+             * @return reference to the key value pair stored in the node
+             */
+            reference operator*() const {
+                return stack.back()->pair;
+            }
+
+            /**
+             * @brief Member access operator.
+             * @return The key value pair in node.
+             */
+            pointer operator->() const {
+                return &stack.back()->pair;
+            }
+
+            /**
+             * @brief Pre-increment operator. Moves to the smallest node of the right subtree,
+             *          or back to the last ancestor whose left subtree is done.
+             *          Runtime: O(1) - amortized.
+             * @return const_iterator ref with the next node.
+             */
+            const_iterator& operator++() {
+                const Node* n = stack.back()->right;
+                stack.pop_back();
+                push_left(n);
+                return *this;
+            }
+
+            /**
+             * @brief Post-increment operator.
+             * @return const_iterator before it was moved.
+             */
+            const_iterator operator++(int) {
+                auto tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Equality operator. Checks if the iterators are at the same node.
+             * @param rhs const_iterator ref to compare with.
+             * @return true if this is equal to rhs
+             */
+            bool operator==(const const_iterator& rhs) const {
+                if(stack.empty() || rhs.stack.empty())
+                    return stack.empty() == rhs.stack.empty();
+                return stack.back() == rhs.stack.back();
+            }
+
+            /**
+             * @brief Inequality operator.
+             * @param rhs const_iterator ref to compare with.
+             * @return true if this is not equal to rhs
+             */
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+
+            private:
+                std::vector<const Node*> stack; // the current node is at the back
+
+                /**
+                 * @brief Pushes a node and its left spine. The smallest node ends at the back.
+                 * @param n root of a subtree.
+                 */
+                void push_left(const Node* n) {
+                    for(; n; n = n->left)
+                        stack.push_back(n);
+                }
+        };
+
+        /**
+         * @brief Default Construct a new PersistentTree object
+         */
+        PersistentTree() {
+            root = nullptr;
+            tree_size = max_size = 0;
+            alpha = 0.57;
+        }
+
+        /**
+         * @brief Construct a new PersistentTree object with comparitor as parameter
+         * @param Comp object
+         */
+        PersistentTree(Comp compare) : PersistentTree() {
+            comp = compare;
+        }
+
+        /**
+         * @brief Construct a new PersistentTree object from a sorted range of key value pairs,
+         *          for example a Tree. The tree is built perfectly balanced.
+         *          Pre-condition: the keys must be sorted by compare and unique.
+         *
+         *          Runtime: O(n)
+         * @param from iterator to the first pair.
+         * @param to past the end iterator of the range.
+         * @param compare Comp object.
+         */
+        template<typename InputIt>
+        PersistentTree(InputIt from, InputIt to, Comp compare = Comp()) : PersistentTree(compare) {
+            std::vector<value_type> items(from, to);
+            std::vector<const value_type*> pairs;
+            pairs.reserve(items.size());
+            for(auto& p : items)
+                pairs.push_back(&p);
+            root = build(pairs, 0, pairs.size());
+            tree_size = max_size = pairs.size();
+        }
+
+        /**
+         * @brief Copy Construct a new PersistentTree object. The copy shares all nodes with other, see snapshot().
+         *          Running time: O(1)
+         * @param other tree to copy.
+         */
+        PersistentTree(const PersistentTree& other) : root(retain(other.root)), comp(other.comp),
+            tree_size(other.tree_size), max_size(other.max_size), alpha(other.alpha) {}
+
+        /**
+         * @brief Copy Assign - overloading '='. This tree shares all nodes with other, see snapshot().
+         *          Running time: O(1), and the old nodes which are not shared are freed.
+         * @param other tree to copy.
+         * @return PersistentTree& copy of tree.
+         */
+        PersistentTree& operator=(const PersistentTree& other) {
+            if(this == &other) return *this;
+            Node* old = root;
+            root = retain(other.root);
+            release(old);
+            comp = other.comp;
+            tree_size = other.tree_size;
+            max_size = other.max_size;
+            alpha = other.alpha;
+            return *this;
+        }
+
+        /**
+         * @brief Move Constructer. This tree takes other trees reference to the nodes.
+         * @param other tree object.
+         */
+        PersistentTree(PersistentTree&& other) : root(other.root), comp(other.comp),
+            tree_size(other.tree_size), max_size(other.max_size), alpha(other.alpha) {
+            other.root = nullptr;
+            other.tree_size = other.max_size = 0;
+        }
+
+        /**
+         * @brief Move Assignment operator. This tree takes other trees reference to the nodes.
+         * @param other tree object.
+         */
+        PersistentTree& operator=(PersistentTree&& other) {
+            if(this == &other) return *this;
+            release(root);
+            root = other.root;
+            comp = other.comp; // other stays usable, so its comparator is copied
+            tree_size = other.tree_size;
+            max_size = other.max_size;
+            alpha = other.alpha;
+            other.root = nullptr;
+            other.tree_size = other.max_size = 0;
+            return *this;
+        }
+
+        /**
+         * @brief Destroy the PersistentTree object. Frees the nodes which no snapshot uses.
+         */
+        ~PersistentTree() {
+            release(root);
+        }
+
+        /**
+         * @brief Makes a snapshot of the current version. Later changes to this tree are not seen by the snapshot,
+         *          and changes to the snapshot are not seen by this tree.
+         *
+         *          The snapshot gets a copy of the comparator.
+         *
+         *          Runtime: O(1)
+         * @return PersistentTree sharing all nodes with this tree.
+         */
+        PersistentTree snapshot() const {
+            return PersistentTree(*this);
+        }
+
+        /**
+         * @brief Returns the comparator of the tree, like Tree::key_comp().
+         * @return Comp a copy of the comparator.
+         */
+        Comp key_comp() const {
+            return comp;
+        }
+
+        /**
+         * @brief Return size of tree.
+         * @return int
+         */
+        int size() const {
+            return tree_size;
+        }
+
+        /**
+         * @brief Checks if size of tree is 0.
+         * @return true if size = 0
+         */
+        bool empty() const {
+            return tree_size == 0;
+        }
+
+        /**
+         * @brief Inserts a new node, or changes the value if the key exists, like Tree::insert().
+         *          The shared nodes on the path to the node are copied. If the new node is too deep,
+         *          the scapegoat subtree is built again from new nodes.
+         *
+         *          Runtime: O_A(log n) - amortized.
+         * @param key of the node
+         * @param value value of the node
+         * @return true if the node was inserted or its value was changed.
+         */
+        bool insert(const Key& key, const Value& value) {
+            const Node* found = find_node(key);
+            if(found && !(found->pair.second != value))
+                return false; // nothing changes, so nothing is copied
+            std::vector<Node**> path; // links to the nodes on the path, all unshared
+            Node** link = &root;
+            while(*link) {
+                Node* n = own(link);
+                path.push_back(link);
+                if(comp(key, n->pair.first))
+                    link = &n->left;
+                else if(comp(n->pair.first, key))
+                    link = &n->right;
+                else {
+                    n->pair.second = value;
+                    return true;
+                }
+            }
+            *link = new Node(key, value);
+            for(Node** l : path)
+                (*l)->size++;
+            tree_size++;
+            max_size = std::max(max_size, tree_size);
+            if(int(path.size()) > h_alpha() && tree_size > 2) { //Find scapegoat node:
+                for(int i = path.size() - 1; i >= 0; i--) {
+                    Node* scn = *path[i];
+                    int n_size = scn->size;
+                    if(!(node_size(scn->left) <= alpha * n_size && node_size(scn->right) <= alpha * n_size)) {
+                        rebuild(path[i]);
+                        max_size = tree_size;
+                        break;
+                    }
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Removes a node given the key. Does nothing if the key is not in the tree.
+         *          The shared nodes on the path to the node and to its successor are copied.
+         *
+         *          Runtime: O_A(log n) - amortized
+         * @param key of node to remove.
+         */
+        void erase(const Key& key) {
+            if(!find_node(key))
+                return;
+            std::vector<Node**> path;
+            Node** link = &root;
+            while(true) {
+                Node* n = own(link);
+                if(comp(key, n->pair.first)) {
+                    path.push_back(link);
+                    link = &n->left;
+                } else if(comp(n->pair.first, key)) {
+                    path.push_back(link);
+                    link = &n->right;
+                } else
+                    break;
+            }
+            Node* node = *link; // unshared now, and the reference from its parent is ours
+            if(node->left == nullptr || node->right == nullptr) {
+                *link = node->left ? node->left : node->right; // the child reference moves to the parent
+            } else {
+                Node** ylink = &node->right;
+                std::vector<Node**> spine;
+                while(own(ylink)->left) { // successor, the smallest node of the right subtree
+                    spine.push_back(ylink);
+                    ylink = &(*ylink)->left;
+                }
+                Node* y = *ylink;
+                *ylink = y->right;
+                for(Node** l : spine)
+                    (*l)->size--;
+                y->left = node->left;
+                y->right = node->right;
+                y->size = node->size - 1;
+                *link = y;
+            }
+            node->left = node->right = nullptr;
+            release(node);
+            for(Node** l : path)
+                (*l)->size--;
+            tree_size--;
+            //rebuild tree at root if too unbalanced.
+            if(tree_size < alpha * max_size) {
+                rebuild(&root);
+                max_size = tree_size;
+            }
+        }
+
+        /**
+         * @brief Destroys the nodes which no snapshot uses, and empties the tree.
+         *          Runtime: O(n)
+         */
+        void clear() {
+            release(root);
+            root = nullptr;
+            tree_size = max_size = 0;
+        }
+
+        /**
+         * @brief Finds a node given a key.
+         *          Runtime: O(log n)
+         * @param key to find
+         * @return const_iterator at the position to the found node. past the end const_iterator if not found.
+         */
+        const_iterator find(const Key& key) const {
+            const_iterator it = lower_bound(key);
+            if(it != end() && comp(key, it->first))
+                return end();
+            return it;
+        }
+
+        /**
+         * @brief Finds the first node whose key is not smaller than key.
+         *          Runtime: O(log n)
+         * @param key to search for, it does not have to be in the tree.
+         * @return const_iterator at the found node. past the end const_iterator if there is none.
+         */
+        const_iterator lower_bound(const Key& key) const {
+            const_iterator it;
+            for(const Node* n = root; n;) {
+                if(comp(n->pair.first, key)) {
+                    n = n->right;
+                } else { // n is a candidate, its left subtree is searched before it
+                    it.stack.push_back(n);
+                    n = n->left;
+                }
+            }
+            return it;
+        }
+
+        /**
+         * @return const_iterator at the position of the leftmost node.
+         *          Past the end const_iterator if tree is empty.
+         */
+        const_iterator begin() const {
+            const_iterator it;
+            it.push_left(root);
+            return it;
+        }
+
+        /**
+         * @return past the end const_iterator.
+         */
+        const_iterator end() const {
+            return const_iterator();
+        }
+
+        private:
+            Node* root; // this tree holds one reference to the root
+            [[no_unique_address]] Comp comp; // each tree has its own, so trees on other threads never share it
+            int tree_size, max_size;
+            float alpha;
+
+            /**
+             * @brief Adds a reference to a node.
+             * @param n node, can be nullptr.
+             * @return Node* n.
+             */
+            static Node* retain(Node* n) {
+                if(n)
+                    n->refs.fetch_add(1, std::memory_order_relaxed);
+                return n;
+            }
+
+            /**
+             * @brief Removes a reference to a node, and frees it if it was the last one.
+             *          A freed node releases its children in turn, without recursion.
+             * @param n node, can be nullptr.
+             */
+            static void release(Node* n) {
+                if(!n || n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+                if(!n->left && !n->right) {
+                    delete n;
+                    return;
+                }
+                std::vector<Node*> stack{n};
+                while(!stack.empty()) {
+                    Node* x = stack.back();
+                    stack.pop_back();
+                    for(Node* c : {x->left, x->right})
+                        if(c && c->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+                            stack.push_back(c);
+                    delete x;
+                }
+            }
+
+            /**
+             * @brief Makes the node at a link unshared, by replacing it with a copy if it is shared.
+             *          Pre-condition: the node holding the link is unshared, or the link is the root,
+             *          so only this tree can reach the node through it.
+             *          Runtime: O(1)
+             *
+             * @param link to the node, it is changed to the copy.
+             * @return Node* the unshared node.
+             */
+            static Node* own(Node** link) {
+                Node* n = *link;
+                if(n->refs.load(std::memory_order_acquire) == 1)
+                    return n;
+                Node* c = new Node(n->pair.first, n->pair.second);
+                c->left = retain(n->left);
+                c->right = retain(n->right);
+                c->size = n->size;
+                *link = c;
+                release(n);
+                return c;
+            }
+
+            /**
+             * @brief Finds the node with the given key.
+             *          Runtime: O(log n)
+             * @param key to find.
+             * @return const Node* with the key, nullptr if not found.
+             */
+            const Node* find_node(const Key& key) const {
+                const Node* n = root;
+                while(n) {
+                    if(comp(key, n->pair.first))
+                        n = n->left;
+                    else if(comp(n->pair.first, key))
+                        n = n->right;
+                    else
+                        return n;
+                }
+                return nullptr;
+            }
+
+            /**
+             * @brief calculates floor(log_{1/alpha}(n)), n = size of the tree.
+             * @return int
+             */
+            int h_alpha() const {
+                return floor(log(tree_size) / log(1/alpha));
+            }
+
+            /**
+             * @brief Returns the size of the subtree rooted at a node.
+             *          Runtime: O(1)
+             * @param node to find the size on.
+             * @return int size of node, 0 if node is nullptr.
+             */
+            static int node_size(const Node* node) {
+                return node ? node->size : 0;
+            }
+
+            /**
+             * @brief Builds the subtree at a link again, perfectly balanced, from new nodes.
+             *          The old nodes may be shared with snapshots, so they are not reused, but released.
+             *          Runtime: O(size of the subtree)
+             *
+             * @param link to the root of the subtree.
+             */
+            void rebuild(Node** link) {
+                std::vector<const value_type*> pairs;
+                std::vector<const Node*> stack;
+                for(const Node* n = *link; n || !stack.empty();) { // inorder walk
+                    if(n) {
+                        stack.push_back(n);
+                        n = n->left;
+                    } else {
+                        n = stack.back();
+                        stack.pop_back();
+                        pairs.push_back(&n->pair);
+                        n = n->right;
+                    }
+                }
+                Node* old = *link;
+                *link = build(pairs, 0, pairs.size());
+                release(old);
+            }
+
+            /**
+             * @brief Builds a perfectly balanced tree of new nodes from sorted pairs,
+             *          with the same shape as Tree::build().
+             *          Runtime: O(n)
+             *
+             * @param pairs sorted pairs.
+             * @param from index of the first pair of the subtree.
+             * @param n size of the subtree.
+             * @return Node* root of the subtree.
+             */
+            static Node* build(const std::vector<const value_type*>& pairs, int from, int n) {
+                if(n == 0)
+                    return nullptr;
+                int l = n - 1 - (n-1)/2;
+                Node* r = new Node(pairs[from + l]->first, pairs[from + l]->second);
+                r->left = build(pairs, from, l);
+                r->right = build(pairs, from + l + 1, (n-1)/2);
+                r->size = n;
+                return r;
+            }
+    };
+};
+#endif
@@ -0,0 +1,232 @@
+/**
+ * @file Pool.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief A node pool which carves objects out of contiguous blocks.
+ *
+ * @date 2022-05-16
+ */
+#ifndef POOL_H
+#define POOL_H
+
+#include <algorithm>
+#include <new>
+#include <utility>
+
+namespace DM852 {
+template<typename T>
+struct Pool {
+    /**
+     * @brief Construct a new empty Pool object. No memory is allocated until the first create().
+     */
+    Pool() {
+        head = current = nullptr;
+        used = 0;
+        free_list = nullptr;
+    }
+
+    Pool(const Pool& other) = delete;
+    Pool& operator=(const Pool& other) = delete;
+
+    /**
+     * @brief Move Constructer. This pool takes ownership of other pools blocks.
+     * @param other pool object.
+     */
+    Pool(Pool&& other) {
+        head = current = nullptr;
+        used = 0;
+        free_list = nullptr;
+        swap(other);
+    }
+
+    /**
+     * @brief Move Assignment operator.
+     *          Frees the blocks of this pool and takes ownership of other pools blocks.
+     *          All objects in this pool must have been destroyed.
+     * @param other pool object.
+     */
+    Pool& operator=(Pool&& other) {
+        if(this == &other) return *this;
+        release();
+        swap(other);
+        return *this;
+    }
+
+    /**
+     * @brief Destroy the Pool object and frees all blocks.
+     */
+    ~Pool() {
+        release();
+    }
+
+    /**
+     * @brief Constructs an object in a free slot.
+     *          Slots freed by destroy() are reused first, then the current block is used,
+     *          and only when all blocks are full a new block is allocated.
+     *
+     *          Runtime: O(1) - amortized.
+     * @param args arguments forwarded to the constructer of T.
+     * @return T* pointer to the new object.
+     */
+    template<typename... Args>
+    T* create(Args&&... args) {
+        void* mem = allocate();
+        try {
+            return new (mem) T(std::forward<Args>(args)...);
+        } catch(...) {
+            deallocate(mem);
+            throw;
+        }
+    }
+
+    /**
+     * @brief Destroys an object and puts its slot on the free list.
+     *          Runtime: O(1)
+     * @param obj pointer to an object created by this pool.
+     */
+    void destroy(T* obj) {
+        obj->~T();
+        deallocate(obj);
+    }
+
+    /**
+     * @brief Marks every slot as free but keeps the blocks, so the pool can be reused without allocating.
+     *          Pre-condition: all objects must have been destroyed (or be trivially destructible).
+     *
+     *          Runtime: O(1)
+     */
+    void reset() {
+        current = head;
+        used = 0;
+        free_list = nullptr;
+    }
+
+    /**
+     * @brief Frees all blocks.
+     *          Pre-condition: all objects must have been destroyed (or be trivially destructible).
+     *
+     *          Runtime: O(b) where b is the number of blocks.
+     */
+    void release() {
+        while(head) {
+            Block* next = head->next;
+            delete[] head->slots;
+            delete head;
+            head = next;
+        }
+        current = nullptr;
+        used = 0;
+        free_list = nullptr;
+    }
+
+    /**
+     * @brief Takes over all blocks of another pool, so the objects in them belong to this pool
+     *          and must be destroyed by it. The objects are not moved.
+     *          The free slots of other are put on the free list of this pool. other is empty afterwards.
+     *
+     *          Runtime: O(b + f) where b is the number of blocks and f the number of free slots in other.
+     * @param other pool object.
+     */
+    void splice(Pool& other) {
+        if(this == &other || !other.head) return;
+        while(other.free_list) {
+            Slot* slot = other.free_list;
+            other.free_list = slot->next;
+            deallocate(slot);
+        }
+        for(Block* b = other.current; b; b = b->next) { // the rest of the current block and blocks left over from a reset()
+            int from = b == other.current ? other.used : 0;
+            for(int i = b->capacity - 1; i >= from; i--)
+                deallocate(&b->slots[i]);
+        }
+        // the blocks go in front, where all slots are already carved, so allocate() never carves them again
+        Block* tail = other.head;
+        while(tail->next)
+            tail = tail->next;
+        tail->next = head;
+        head = other.head;
+        if(!current) {
+            current = tail;
+            used = tail->capacity;
+        }
+        other.head = other.current = nullptr;
+        other.used = 0;
+    }
+
+    /**
+     * @brief Swaps the blocks of two pools.
+     * @param other pool object.
+     */
+    void swap(Pool& other) {
+        std::swap(head, other.head);
+        std::swap(current, other.current);
+        std::swap(used, other.used);
+        std::swap(free_list, other.free_list);
+    }
+
+    private:
+        /**
+         * @brief A slot holds either an object or a pointer to the next free slot.
+         */
+        union Slot {
+            Slot* next;
+            alignas(T) unsigned char data[sizeof(T)];
+        };
+
+        /**
+         * @brief A contiguous array of slots. Blocks double in size up to max_block.
+         */
+        struct Block {
+            Block* next;
+            Slot* slots;
+            int capacity;
+        };
+
+        static constexpr int first_block = 32;
+        static constexpr int max_block = 8192;
+
+        Block* head;     // first allocated block
+        Block* current;  // block new slots are carved from
+        int used;        // number of carved slots in current
+        Slot* free_list;
+
+        /**
+         * @brief Finds memory for a new object.
+         * @return void* to an unused slot.
+         */
+        void* allocate() {
+            if(free_list) {
+                Slot* slot = free_list;
+                free_list = slot->next;
+                return slot;
+            }
+            if(current == nullptr || used == current->capacity) {
+                if(current && current->next) { // left over from a reset()
+                    current = current->next;
+                } else {
+                    Block* block = new Block;
+                    block->capacity = current ? std::min(current->capacity * 2, max_block) : first_block;
+                    block->slots = new Slot[block->capacity];
+                    block->next = nullptr;
+                    if(current)
+                        current->next = block;
+                    else
+                        head = block;
+                    current = block;
+                }
+                used = 0;
+            }
+            return &current->slots[used++];
+        }
+
+        /**
+         * @brief Puts a slot on the free list.
+         * @param mem pointer to the slot.
+         */
+        void deallocate(void* mem) {
+            Slot* slot = static_cast<Slot*>(mem);
+            slot->next = free_list;
+            free_list = slot;
+        }
+};
+};
+#endif
@@ -0,0 +1,363 @@
+/**
+ * @file Serialize.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief A compact binary format for Tree and List, written and read as a stream.
+ * @date 2022-05-16
+ */
+
+#ifndef SERIALIZE_H
+#define SERIALIZE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "List.hpp"
+#include "Tree.hpp"
+
+namespace DM852 {
+    /**
+     * @brief Writes and reads one value of the binary format.
+     *          Trivially copyable types are stored as their bytes, in whole runs at a time (raw = true).
+     *          Other types need a specialization with raw = false and these two functions,
+     *          like the one for std::string below.
+     */
+    template<typename T>
+    struct Codec;
+
+    template<typename T> requires std::is_trivially_copyable_v<T>
+    struct Codec<T> {
+        static constexpr bool raw = true;
+
+        static void write(std::ostream& os, const T& x) {
+            os.write(reinterpret_cast<const char*>(&x), sizeof(T));
+        }
+
+        static bool read(std::istream& is, T& x) {
+            return bool(is.read(reinterpret_cast<char*>(&x), sizeof(T)));
+        }
+    };
+
+    /**
+     * @brief A string is stored as its length in 7 bit groups (a varint), and its characters.
+     */
+    template<>
+    struct Codec<std::string> {
+        static constexpr bool raw = false;
+        static constexpr std::uint64_t chunk = 1 << 16; // the string grows by at most this much before it is read into
+
+        static void write(std::ostream& os, const std::string& s) {
+            std::uint64_t n = s.size();
+            do {
+                os.put(char((n & 0x7f) | (n > 0x7f ? 0x80 : 0)));
+                n >>= 7;
+            } while(n);
+            os.write(s.data(), s.size());
+        }
+
+        static bool read(std::istream& is, std::string& s) {
+            std::uint64_t n = 0;
+            for(int shift = 0; shift < 64; shift += 7) {
+                int c = is.get();
+                if(c == std::istream::traits_type::eof())
+                    return false;
+                n |= std::uint64_t(c & 0x7f) << shift;
+                if(!(c & 0x80))
+                    break;
+            }
+            // a corrupt length fails at the end of the stream, instead of allocating all of it up front
+            s.clear();
+            while(s.size() < n) {
+                std::size_t old = s.size();
+                std::size_t k = std::min(chunk, n - old);
+                s.resize(old + k);
+                if(!is.read(s.data() + old, k))
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief The first 64 bytes of a file. The elements follow in runs of up to run_size elements.
+     *          A run of a Tree is its keys and then its values, a run of a List is its elements.
+     *          With raw, each part of a run is the bytes of the array, padded with zeros to a multiple of 64,
+     *          so a mapped file can be searched in place, see MappedTree. Without raw, it is the elements one after another,
+     *          written by their Codec.
+     *          The numbers are in the byte order of the machine, and a file of the other byte order is refused.
+     */
+    struct BinaryHeader {
+        static constexpr char tree_magic[8] = {'D', 'M', '8', '5', '2', 'T', 'R', 'E'};
+        static constexpr char list_magic[8] = {'D', 'M', '8', '5', '2', 'L', 'S', 'T'};
+        static constexpr std::uint32_t current_version = 1;
+        static constexpr std::uint32_t default_run_size = 4096;
+        static constexpr int alignment = 64;
+
+        char magic[8];
+        std::uint32_t byte_order = 0x01020304;
+        std::uint32_t version = current_version;
+        std::uint32_t raw = 0;
+        std::uint32_t key_size = 0;   // sizeof(Key) with raw, else 0
+        std::uint32_t value_size = 0; // sizeof(Value) with raw, else 0, and 0 for a List
+        std::uint32_t run_size = default_run_size;
+        std::uint64_t count = 0;
+        unsigned char padding[24] = {};
+
+        /**
+         * @param bytes size of a part of a run.
+         * @return std::uint64_t bytes rounded up to a multiple of alignment.
+         */
+        static constexpr std::uint64_t padded(std::uint64_t bytes) {
+            return (bytes + alignment - 1) / alignment * alignment;
+        }
+
+        /**
+         * @brief Checks that a header read from a file is one this build can read.
+         * @param m magic of the container.
+         * @param is_raw raw of the element types.
+         * @param k key_size of the element types.
+         * @param v value_size of the element types.
+         * @return true if the header matches.
+         */
+        bool matches(const char* m, bool is_raw, std::uint32_t k, std::uint32_t v) const {
+            return std::memcmp(magic, m, 8) == 0 && byte_order == 0x01020304 && version == current_version &&
+                raw == std::uint32_t(is_raw) && key_size == k && value_size == v && run_size > 0;
+        }
+    };
+    static_assert(sizeof(BinaryHeader) == BinaryHeader::alignment);
+
+    /**
+     * @brief One part of a run, an array of up to run_size values of T.
+     */
+    template<typename T>
+    struct BinaryColumn {
+        static constexpr std::uint64_t chunk = std::max<std::uint64_t>(1, (1 << 16) / sizeof(T)); // values read per step
+        std::vector<T> items;
+
+        /**
+         * @brief Writes the values of the column, and empties it.
+         * @param os stream to write to.
+         */
+        void flush(std::ostream& os) {
+            if constexpr(Codec<T>::raw) {
+                std::uint64_t bytes = items.size() * sizeof(T);
+                os.write(reinterpret_cast<const char*>(items.data()), bytes);
+                static constexpr char zeros[BinaryHeader::alignment] = {};
+                os.write(zeros, BinaryHeader::padded(bytes) - bytes);
+            } else {
+                for(const T& x : items)
+                    Codec<T>::write(os, x);
+            }
+            items.clear();
+        }
+
+        /**
+         * @brief Reads n values into the column, in place of the ones in it.
+         *          The column grows by chunk values at a time as they are read, so a corrupt run_size or count
+         *          fails at the end of the stream, instead of allocating all of it up front.
+         * @param is stream to read from.
+         * @param n number of values.
+         * @return true if all values were read.
+         */
+        bool fill(std::istream& is, std::uint64_t n) {
+            items.clear();
+            while(items.size() < n) {
+                std::size_t old = items.size();
+                items.resize(old + std::min(chunk, n - old));
+                if constexpr(Codec<T>::raw) {
+                    if(!is.read(reinterpret_cast<char*>(items.data() + old), (items.size() - old) * sizeof(T)))
+                        return false;
+                } else {
+                    for(std::size_t i = old; i < items.size(); i++)
+                        if(!Codec<T>::read(is, items[i]))
+                            return false;
+                }
+            }
+            if constexpr(Codec<T>::raw) {
+                std::uint64_t bytes = n * sizeof(T);
+                std::streamsize pad = BinaryHeader::padded(bytes) - bytes;
+                return is.ignore(pad).gcount() == pad; // ignore() does not fail at the end of the stream
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Writes a tree in the binary format. The pairs are written in sorted order, one run at a time,
+     *          so only one run is held in memory.
+     *
+     *          Runtime: O(n)
+     * @param os stream to write to.
+     * @param tree to write.
+     * @return true if the stream had no error.
+     */
+    template<typename Key, typename Value, typename Comp, typename Stats>
+    bool write_binary(std::ostream& os, const Tree<Key, Value, Comp, Stats>& tree) {
+        BinaryHeader header;
+        std::memcpy(header.magic, BinaryHeader::tree_magic, 8);
+        header.raw = Codec<Key>::raw && Codec<Value>::raw;
+        if(header.raw) {
+            header.key_size = sizeof(Key);
+            header.value_size = sizeof(Value);
+        }
+        header.count = tree.size();
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        BinaryColumn<Key> keys;
+        BinaryColumn<Value> values;
+        for(auto it = tree.begin(); it != tree.end(); ++it) {
+            keys.items.push_back(it->first);
+            values.items.push_back(it->second);
+            if(keys.items.size() == header.run_size) {
+                keys.flush(os);
+                values.flush(os);
+            }
+        }
+        if(!keys.items.empty()) {
+            keys.flush(os);
+            values.flush(os);
+        }
+        return bool(os);
+    }
+
+    /**
+     * @brief Reads a tree written by write_binary(), in place of the content of the tree.
+     *          The pairs are read one run at a time and given to Tree::assign() as a sorted range,
+     *          so the tree is made by one build() without any searches.
+     *          On an error the tree is left empty.
+     *
+     *          Runtime: O(n)
+     * @param is stream to read from.
+     * @param tree to read into.
+     * @return true if the whole tree was read. false if the header does not match the types or the stream ended early.
+     */
+    template<typename Key, typename Value, typename Comp, typename Stats>
+    bool read_binary(std::istream& is, Tree<Key, Value, Comp, Stats>& tree) {
+        tree.clear();
+        BinaryHeader header;
+        constexpr bool raw = Codec<Key>::raw && Codec<Value>::raw;
+        if(!is.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+           !header.matches(BinaryHeader::tree_magic, raw, raw ? sizeof(Key) : 0, raw ? sizeof(Value) : 0))
+            return false;
+
+        /**
+         * @brief The pairs read so far, and the run the next pairs come from.
+         */
+        struct Reader {
+            std::istream& is;
+            const BinaryHeader& header;
+            BinaryColumn<Key> keys;
+            BinaryColumn<Value> values;
+            std::uint64_t read = 0; // pairs given out
+            std::uint64_t pos = 0;  // position in the run
+            std::pair<Key, Value> current;
+            bool ok = true;
+
+            /**
+             * @brief Moves to the next pair, and reads the next run when the current one is used up.
+             * @return true if there is a next pair.
+             */
+            bool next() {
+                if(!ok || read == header.count)
+                    return false;
+                if(pos == keys.items.size()) {
+                    std::uint64_t n = std::min<std::uint64_t>(header.run_size, header.count - read);
+                    if(!keys.fill(is, n) || !values.fill(is, n))
+                        return ok = false;
+                    pos = 0;
+                }
+                current.first = std::move(keys.items[pos]);
+                current.second = std::move(values.items[pos]);
+                pos++;
+                read++;
+                return true;
+            }
+        } reader{is, header};
+
+        /**
+         * @brief Input iterator over the pairs of the reader.
+         */
+        struct Iterator {
+            Reader* reader; // nullptr at the end
+            const std::pair<Key, Value>& operator*() const { return reader->current; }
+            Iterator& operator++() {
+                if(!reader->next())
+                    reader = nullptr;
+                return *this;
+            }
+            bool operator!=(const Iterator& rhs) const { return reader != rhs.reader; }
+        };
+
+        Iterator from{reader.next() ? &reader : nullptr};
+        tree.assign(from, Iterator{nullptr});
+        if(!reader.ok || reader.read != header.count) {
+            tree.clear();
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Writes a list in the binary format, one run at a time.
+     *
+     *          Runtime: O(n)
+     * @param os stream to write to.
+     * @param list to write.
+     * @return true if the stream had no error.
+     */
+    template<typename T>
+    bool write_binary(std::ostream& os, const List<T>& list) {
+        BinaryHeader header;
+        std::memcpy(header.magic, BinaryHeader::list_magic, 8);
+        header.raw = Codec<T>::raw;
+        if(header.raw)
+            header.key_size = sizeof(T);
+        header.count = list.size();
+        os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        BinaryColumn<T> items;
+        for(auto it = list.begin(); it != list.end(); ++it) {
+            items.items.push_back(*it);
+            if(items.items.size() == header.run_size)
+                items.flush(os);
+        }
+        if(!items.items.empty())
+            items.flush(os);
+        return bool(os);
+    }
+
+    /**
+     * @brief Reads a list written by write_binary(), in place of the content of the list.
+     *          On an error the list is left empty.
+     *
+     *          Runtime: O(n)
+     * @param is stream to read from.
+     * @param list to read into.
+     * @return true if the whole list was read. false if the header does not match the type or the stream ended early.
+     */
+    template<typename T>
+    bool read_binary(std::istream& is, List<T>& list) {
+        list.clear();
+        BinaryHeader header;
+        if(!is.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+           !header.matches(BinaryHeader::list_magic, Codec<T>::raw, Codec<T>::raw ? sizeof(T) : 0, 0))
+            return false;
+        BinaryColumn<T> items;
+        for(std::uint64_t read = 0; read < header.count;) {
+            std::uint64_t n = std::min<std::uint64_t>(header.run_size, header.count - read);
+            if(!items.fill(is, n)) {
+                list.clear();
+                return false;
+            }
+            for(T& x : items.items)
+                list.push_back(std::move(x));
+            read += n;
+        }
+        return true;
+    }
+};
+#endif
@@ -0,0 +1,322 @@
+/**
+ * @file ShardedTree.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Header file for a map which spreads its keys over several Scapegoat trees.
+ * @date 2022-05-16
+ */
+
+#ifndef SHARDED_TREE_H
+#define SHARDED_TREE_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Tree.hpp"
+
+namespace DM852 {
+    /**
+     * @brief A map whose keys are hash partitioned over a number of independent Trees, the shards.
+     *          Every shard has its own lock and its own node pool, so writers to different shards
+     *          do not wait for each other, and a rebuild only stops the keys of one shard.
+     *          Lookups take the lock of their shard shared, so they run in parallel with each other.
+     *          Ordered iteration merges the shards, which are each sorted.
+     */
+    template<typename Key, typename Value, typename Comp = std::less<Key>, typename Hash = std::hash<Key>>
+    struct ShardedTree {
+        using tree_type = Tree<Key, Value, Comp>;
+        using value_type = typename tree_type::value_type;
+
+        /**
+         * @brief Construct a new empty ShardedTree object.
+         * @param shards number of trees, at least 1. More shards than writing threads makes waiting rare.
+         * @param hash Hash object.
+         * @param compare Comp object, used by every shard and by the merge of the shards.
+         */
+        explicit ShardedTree(int shards = 16, Hash hash = Hash(), Comp compare = Comp()) : hash(hash), comp(compare) {
+            shards = std::max(shards, 1);
+            for(int i = 0; i < shards; i++)
+                this->shards.push_back(std::make_unique<Shard>(comp));
+        }
+
+        ShardedTree(const ShardedTree& other) = delete;
+        ShardedTree& operator=(const ShardedTree& other) = delete;
+
+        /**
+         * @brief Return the number of shards.
+         * @return int
+         */
+        int shard_count() const {
+            return shards.size();
+        }
+
+        /**
+         * @brief Returns the comparator of the map, like Tree::key_comp().
+         * @return Comp a copy of the comparator.
+         */
+        Comp key_comp() const {
+            return comp;
+        }
+
+        /**
+         * @brief Return size of the map. The shards are counted one at a time,
+         *          so with concurrent writers the result is only a snapshot of each shard.
+         *          Runtime: O(shards)
+         * @return int
+         */
+        int size() const {
+            int res = 0;
+            for(auto& shard : shards) {
+                std::shared_lock<std::shared_mutex> lock(shard->lock);
+                res += shard->tree.size();
+            }
+            return res;
+        }
+
+        /**
+         * @brief Checks if size of the map is 0.
+         * @return true if size = 0
+         */
+        bool empty() const {
+            return size() == 0;
+        }
+
+        /**
+         * @brief Inserts a node, or changes the value if the key exists. See Tree::insert().
+         *          Runtime: O_A(log(n / shards)) - amortized.
+         * @param key of the node.
+         * @param value of the node.
+         * @return true if the node was inserted or its value was changed.
+         */
+        bool insert(const Key& key, const Value& value) {
+            Shard& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            return shard.tree.insert(key, value).second;
+        }
+
+        /**
+         * @brief Assigns the value to the node with the key, or inserts a new node. See Tree::insert_or_assign().
+         *          Runtime: O_A(log(n / shards)) - amortized.
+         * @param key of the node.
+         * @param value to assign or insert.
+         * @return true if the node was inserted.
+         */
+        template<typename M>
+        bool insert_or_assign(const Key& key, M&& value) {
+            Shard& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            return shard.tree.insert_or_assign(key, std::forward<M>(value)).second;
+        }
+
+        /**
+         * @brief Removes a node given the key. Does nothing if the key is not in the map.
+         *          Runtime: O_A(log(n / shards)) - amortized.
+         * @param key of node to remove.
+         */
+        void erase(const Key& key) {
+            Shard& shard = shard_of(key);
+            std::unique_lock<std::shared_mutex> lock(shard.lock);
+            shard.tree.erase(key);
+        }
+
+        /**
+         * @brief Finds the value of a key.
+         *          Runtime: O(log(n / shards))
+         * @param key to find.
+         * @return std::optional<Value> a copy of the value, empty if the key is not in the map.
+         */
+        std::optional<Value> find(const Key& key) const {
+            const Shard& shard = shard_of(key);
+            std::shared_lock<std::shared_mutex> lock(shard.lock);
+            auto it = shard.tree.find(key);
+            if(it == shard.tree.end())
+                return std::nullopt;
+            return it->second;
+        }
+
+        /**
+         * @brief Checks if a key is in the map.
+         *          Runtime: O(log(n / shards))
+         * @param key to find.
+         * @return true if the key is in the map.
+         */
+        bool contains(const Key& key) const {
+            const Shard& shard = shard_of(key);
+            std::shared_lock<std::shared_mutex> lock(shard.lock);
+            return shard.tree.find(key) != shard.tree.end();
+        }
+
+        /**
+         * @brief Destroys all nodes. The shards are cleared in parallel.
+         *          Runtime: O(n / threads)
+         */
+        void clear() {
+            parallel_for_shards([](Shard& shard) {
+                std::unique_lock<std::shared_mutex> lock(shard.lock);
+                shard.tree.clear();
+            });
+        }
+
+        /**
+         * @brief Inserts a range of key value pairs. The range is split by shard first,
+         *          and then every shard inserts its part as a batch, in parallel. See Tree::insert_batch().
+         *          Equal keys behave like calling insert() in order, so the last value wins.
+         *
+         *          Runtime: O(n / threads * log n)
+         * @param from iterator to the first pair.
+         * @param to past the end iterator of the range.
+         * @return int number of keys that were not in the map before.
+         */
+        template<typename InputIt>
+        int load(InputIt from, InputIt to) {
+            std::vector<std::vector<std::pair<Key, Value>>> parts(shards.size());
+            for(; from != to; ++from)
+                parts[index_of((*from).first)].emplace_back((*from).first, (*from).second);
+            std::vector<int> inserted(shards.size(), 0);
+            parallel_for_index([&](size_t i) {
+                std::unique_lock<std::shared_mutex> lock(shards[i]->lock);
+                inserted[i] = shards[i]->tree.insert_batch(parts[i].begin(), parts[i].end());
+            });
+            int res = 0;
+            for(int n : inserted)
+                res += n;
+            return res;
+        }
+
+        /**
+         * @brief Calls a function for every pair in sorted order, by merging the sorted shards.
+         *          All shards are locked shared while it runs, so it sees one consistent version of the map,
+         *          and writers wait until it is done. The function must not change the map.
+         *
+         *          Runtime: O(n log(shards))
+         * @param f function which is called with a const value_type& for every pair.
+         */
+        template<typename F>
+        void for_each(F&& f) const {
+            merge(nullptr, nullptr, f);
+        }
+
+        /**
+         * @brief Calls a function for every pair with a key in [lo, hi) in sorted order. See for_each().
+         *          Runtime: O(shards * log n + k log(shards)), k is the number of pairs in the range.
+         * @param lo smallest key of the range.
+         * @param hi the first key after the range.
+         * @param f function which is called with a const value_type& for every pair in the range.
+         */
+        template<typename F>
+        void for_each(const Key& lo, const Key& hi, F&& f) const {
+            merge(&lo, &hi, f);
+        }
+
+        private:
+            /**
+             * @brief A tree and its lock, in their own cache lines so the locks of two shards do not share a line.
+             */
+            struct alignas(64) Shard {
+                mutable std::shared_mutex lock;
+                tree_type tree;
+
+                explicit Shard(Comp compare) : tree(compare) {}
+            };
+
+            std::vector<std::unique_ptr<Shard>> shards;
+            Hash hash;
+            [[no_unique_address]] Comp comp;
+
+            /**
+             * @brief Finds the shard of a key. The hash is mixed first, so hashes which
+             *          only differ in the high bits, or are the identity like for integers, still spread out.
+             * @param key to find the shard of.
+             * @return size_t index of the shard.
+             */
+            size_t index_of(const Key& key) const {
+                uint64_t h = uint64_t(hash(key)) * 0x9E3779B97F4A7C15ull; // Fibonacci hashing
+                return (h >> 32) % shards.size();
+            }
+
+            Shard& shard_of(const Key& key) {
+                return *shards[index_of(key)];
+            }
+
+            const Shard& shard_of(const Key& key) const {
+                return *shards[index_of(key)];
+            }
+
+            /**
+             * @brief Calls a function for every shard index, spread over up to one thread per core.
+             * @param f function which is called with the index of a shard.
+             */
+            template<typename F>
+            void parallel_for_index(F&& f) {
+                size_t threads = std::min<size_t>(shards.size(), std::max(1u, std::thread::hardware_concurrency()));
+                std::vector<std::thread> pool;
+                for(size_t t = 1; t < threads; t++)
+                    pool.emplace_back([&f, t, threads, this] {
+                        for(size_t i = t; i < shards.size(); i += threads)
+                            f(i);
+                    });
+                for(size_t i = 0; i < shards.size(); i += threads) // the calling thread takes its part too
+                    f(i);
+                for(auto& thread : pool)
+                    thread.join();
+            }
+
+            /**
+             * @brief Calls a function for every shard, in parallel. See parallel_for_index().
+             * @param f function which is called with a Shard&.
+             */
+            template<typename F>
+            void parallel_for_shards(F&& f) {
+                parallel_for_index([&f, this](size_t i) {
+                    f(*shards[i]);
+                });
+            }
+
+            /**
+             * @brief k-way merge of the shards, optionally of the keys in [*lo, *hi) only.
+             *          The next pair of every shard is kept in a binary heap ordered by key.
+             *
+             * @param lo smallest key, nullptr for no lower bound.
+             * @param hi the first key after the range, nullptr for no upper bound.
+             * @param f function which is called with every pair in sorted order.
+             */
+            template<typename F>
+            void merge(const Key* lo, const Key* hi, F& f) const {
+                using iter = typename tree_type::const_iterator;
+                std::vector<std::shared_lock<std::shared_mutex>> locks;
+                for(auto& shard : shards)
+                    locks.emplace_back(shard->lock);
+                std::vector<std::pair<iter, iter>> heap; // next pair and end of every shard
+                for(auto& shard : shards) {
+                    const tree_type& tree = shard->tree;
+                    iter from = lo ? tree.lower_bound(*lo) : tree.begin();
+                    iter to = hi ? tree.lower_bound(*hi) : tree.end();
+                    if(lo && hi && !comp(*lo, *hi))
+                        to = from;
+                    if(from != to)
+                        heap.emplace_back(from, to);
+                }
+                auto later = [this](const std::pair<iter, iter>& a, const std::pair<iter, iter>& b) {
+                    return comp(b.first->first, a.first->first); // min heap on the key
+                };
+                std::make_heap(heap.begin(), heap.end(), later);
+                while(!heap.empty()) {
+                    std::pop_heap(heap.begin(), heap.end(), later);
+                    auto& top = heap.back();
+                    f(*top.first);
+                    if(++top.first == top.second)
+                        heap.pop_back();
+                    else
+                        std::push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+    };
+};
+#endif
@@ -9,143 +9,89 @@
 #define TREE_H
 
 #include <math.h>
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <compare>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <type_traits>
 #include <utility>
 #include <numeric>
+#include <ranges>
+#include <thread>
+#include <vector>
+
+#include "FrozenTree.hpp"
+#include "Pool.hpp"
+#include "TreeStats.hpp"
 
 namespace DM852 {
-    template<typename Key, typename Value, typename Comp = std::less<Key>>
+    template<typename Key, typename Value, typename Comp = std::less<Key>, typename Stats = NoStats>
     struct Tree {
         using value_type = std::pair<const Key, Value>;
+
+        /**
+         * @brief What to do with equal keys when building a tree from a sorted range.
+         *          keep_last gives the same result as inserting the elements one by one.
+         */
+        enum class duplicates { keep_first, keep_last };
     private:
         /**
          * @brief Nested Node class
+         *          The nodes have no parent pointers. Instead they are also linked in a doubly linked
+         *          list in sorted order, so the successor and predecessor are one pointer away, and
+         *          the operations which need the ancestors of a node collect them on the way down.
          */
         struct Node {
-            Node* parent;
             Node* left;
             Node* right;
-            std::pair<const Key, Value>* pair;
+            Node* succ; // next node in sorted order, nullptr for the last node
+            Node* pred; // previous node in sorted order, nullptr for the first node
+            value_type pair; // stored inline, so a lookup touches one allocation per level
+            int size; // number of nodes in the subtree rooted at this node
 
             /**
              * @brief Finds the successor of the node.
-             *          Runtime: O(h) where h is the height of the tree.
-             *            But because it is self balancing and loosely
-             *            alpha-height-balanced: h < h_alpha(n) + 1
-             *            the running time is O(h_alpha(n))
+             *          Runtime: O(1), no keys are compared.
              * @return Node* to the successor.
              */
-            Node* next() {
-                if(right) {
-                    Node* res = right;
-                    while(res->left) {
-                        res = res->left;
-                    }
-                    return res;
-                }
-                if(parent && comp(pair->first, parent->pair->first))
-                    return parent;  //if leaf and parent is bigger, the next should be the parent
-                if(parent && parent->parent && comp(parent->pair->first, parent->parent->pair->first)) // if the next node is the parents parent
-                    return parent->parent;
-                return nullptr;
-            }
-
-            /**
-             * @brief Overloaded next() function.
-             * @return const Node* to the successor.
-             */
-            const Node* next() const {
-                if(right) {
-                    Node* res = right;
-                    while(res->left) {
-                        res = res->left;
-                    }
-                    return res;
-                }
-                if(parent && comp(pair->first, parent->pair->first))
-                    return parent;  //if leaf and parent is bigger, the next should be the parent
-                if(parent && parent->parent && comp(parent->pair->first, parent->parent->pair->first)) // if the next node is the parents parent
-                    return parent->parent;
-                return nullptr;
+            Node* next() const {
+                return succ;
             }
 
             /**
              * @brief Finds the predecessor of the node.
-             *          Runtime: O(h) where h is the height of the tree.
-             *            But because it is self balancing and loosely 
-             *            alpha-height-balanced: h < h_alpha(n) + 1
-             *            the running time is O(h_alpha(n))
+             *          Runtime: O(1), no keys are compared.
              * @return Node* to the predecessor.
              */
-            Node* prev() {
-                if(left) {
-                    Node* res = left;
-                    while(res->right) {
-                        res = res->right;
-                    }
-                    return res;
-                }
-                if(parent && comp(parent->pair->first, pair->first)) {
-                    return parent;  //if leaf and parent is bigger, the prev should be the parent
-                }
-                if(parent && parent->parent && comp(parent->parent->pair->first, parent->pair->first)) // if the prev node is the parents parent
-                    return parent->parent;
-                return nullptr;
-            }
-
-            /**
-             * @brief Overloaded prev() function.
-             * @return const Node* to the predecessor.
-             */
-            const Node* prev() const {
-                if(left) {
-                    Node* res = left;
-                    while(res->right) {
-                        res = res->right;
-                    }
-                    return res;
-                }
-                if(parent && comp(parent->pair->first, pair->first)) {
-                    return parent;  //if leaf and parent is bigger, the prev should be the parent
-                }
-                if(parent && parent->parent && comp(parent->parent->pair->first, parent->pair->first)) // if the prev node is the parents parent
-                    return parent->parent;
-                return nullptr;
-            }
-
-            /**
-             * @brief Construct a new Node object, and creates a pair object of the key and value.
-             * @param key key of the node
-             * @param value value of the node
-             */
-            Node(const Key& key, const Value& value) {
-                pair = new std::pair<const Key, Value>(key, value);
-                parent = left = right = nullptr;
-            }
-
-            /**
-             * @brief Move Construct a new Node object, and creates a pair object of the key and value.
-             * @param key rvalue key of the node
-             * @param value rvalue value of the node
-             */
-            Node(Key&& key, Value&& value) {
-                pair = new std::pair<const Key, Value>(std::move(key), std::move(value));
-                parent = left = right = nullptr;
+            Node* prev() const {
+                return pred;
             }
 
             /**
-             * @brief Destroy the Node object
+             * @brief Construct a new Node object, and constructs the key value pair in the node.
+             * @param args arguments forwarded to the constructer of value_type,
+             *          for example the key and the value.
              */
-            ~Node() {
-                delete left;
-                delete right;
-                delete pair;
+            template<typename... Args>
+            Node(Args&&... args) : pair(std::forward<Args>(args)...) {
+                left = right = succ = pred = nullptr;
+                size = 1;
             }
         };
     public:
         struct iterator {
             friend class Tree;
             friend class const_iterator;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
             using value_type = std::pair<const Key, Value>;
+            using pointer = value_type*;
             using reference = value_type&;
 
             /**
@@ -158,7 +104,7 @@ namespace DM852 {
              * @param tree reference to the tree which the node belongs to.
              * @param ptr pointer to the node where the iterator starts.
              */
-            iterator(Tree& tree, Node* node) : tree(tree), ptr(node) {}
+            iterator(Tree& tree, Node* node) : tree(&tree), ptr(node) {}
 
             /**
              * @brief Copy Construct iterator.
@@ -186,7 +132,7 @@ namespace DM852 {
              * @return reference to the key value pair stored in the node
              */
             reference operator*() const {
-                return *(ptr->pair);
+                return ptr->pair;
             }
 
             /**
@@ -215,7 +161,7 @@ namespace DM852 {
              */
             iterator& operator--() {
                 if(ptr == nullptr)
-                    ptr = tree.last;
+                    ptr = tree->last;
                 else
                     ptr = ptr->prev();
                 return *this;
@@ -229,7 +175,7 @@ namespace DM852 {
             iterator operator--(int) {
                 auto tmp = *this;
                 if(ptr == nullptr)
-                    ptr = tree.last;
+                    ptr = tree->last;
                 else
                     ptr = ptr->prev();
                 return tmp;
@@ -240,7 +186,7 @@ namespace DM852 {
              * @param rhs iterator ref to compare with.
              * @return true if this is equal to rhs
              */
-            bool operator==(const iterator& rhs) {
+            bool operator==(const iterator& rhs) const {
                 return ptr == rhs.ptr;
             }
 
@@ -250,7 +196,7 @@ namespace DM852 {
              * @param rhs iterator ref to compare with.
              * @return true if this is not equal to rhs
              */
-            bool operator!=(const iterator& rhs) {
+            bool operator!=(const iterator& rhs) const {
                 return ptr != rhs.ptr;
             }
 
@@ -258,18 +204,21 @@ namespace DM852 {
              * @brief Member access operator.
              * @return The key value pair in node.
              */
-            value_type* operator->() {
-                return ptr->pair;
+            value_type* operator->() const {
+                return &ptr->pair;
             }
 
             private:
-                Tree& tree;
-                Node* ptr;
+                Tree* tree = nullptr;
+                Node* ptr = nullptr;
         };
         struct const_iterator {
             friend class Tree;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
             using value_type = std::pair<const Key, Value>;
-            using reference = value_type&;
+            using pointer = const value_type*;
+            using reference = const value_type&;
 
             /**
              * @brief Default constructer.
@@ -281,7 +230,7 @@ namespace DM852 {
              * @param tree reference to the tree which the node belongs to.
              * @param ptr pointer to the node where the const_iterator starts.
              */
-            const_iterator(const Tree& tree, Node* node) : tree(tree), ptr(node) {}
+            const_iterator(const Tree& tree, Node* node) : tree(&tree), ptr(node) {}
 
             /**
              * @brief Copy Construct const_iterator.
@@ -325,7 +274,7 @@ namespace DM852 {
              * @return reference to the key value pair stored in the node
              */
             reference operator*() const {
-                return *(ptr->pair);
+                return ptr->pair;
             }
 
             /**
@@ -354,7 +303,7 @@ namespace DM852 {
              */
             const_iterator& operator--() {
                 if(ptr == nullptr)
-                    ptr = tree.last;
+                    ptr = tree->last;
                 else
                     ptr = ptr->prev();
                 return *this;
@@ -368,7 +317,7 @@ namespace DM852 {
             const_iterator operator--(int) {
                 auto tmp = *this;
                 if(ptr == nullptr)
-                    ptr = tree.last;
+                    ptr = tree->last;
                 else
                     ptr = ptr->prev();
                 return tmp;
@@ -379,7 +328,7 @@ namespace DM852 {
              * @param rhs const_iterator ref to compare with.
              * @return true if this is equal to rhs
              */
-            bool operator==(const const_iterator& rhs) {
+            bool operator==(const const_iterator& rhs) const {
                 return ptr == rhs.ptr;
             }
 
@@ -389,7 +338,7 @@ namespace DM852 {
              * @param rhs const_iterator  ref to compare with.
              * @return true if this is not equal to rhs
              */
-            bool operator!=(const const_iterator& rhs) {
+            bool operator!=(const const_iterator& rhs) const {
                 return ptr != rhs.ptr;
             }
 
@@ -398,12 +347,12 @@ namespace DM852 {
              * @return The key value pair in node.
              */
             const value_type* operator->() const {
-                return ptr->pair;
+                return &ptr->pair;
             }
 
             private:
-                const Tree& tree;
-                Node* ptr;
+                const Tree* tree = nullptr;
+                Node* ptr = nullptr;
         };
 
         /**
@@ -427,58 +376,77 @@ namespace DM852 {
             comp = compare;
         }
 
+        /**
+         * @brief Construct a new Tree object with a balance factor, see set_alpha().
+         * @param alpha balance factor, it is clamped to [min_alpha, max_alpha].
+         * @param Comp object
+         */
+        explicit Tree(float alpha, Comp compare = Comp()) {
+            root = first = last = nullptr;
+            tree_size = max_size = 0;
+            set_alpha(alpha);
+            comp = compare;
+        }
+
+        /**
+         * @brief Construct a new Tree object from a sorted range of key value pairs.
+         *          See assign().
+         *
+         *          Runtime: O(n) if the range is sorted.
+         * @param from iterator to the first pair.
+         * @param to past the end iterator of the range.
+         * @param policy which value to keep for equal keys.
+         */
+        template<typename InputIt>
+        Tree(InputIt from, InputIt to, duplicates policy = duplicates::keep_last) {
+            root = first = last = nullptr;
+            tree_size = max_size = 0;
+            alpha = 0.57;
+            comp = Comp();
+            assign(from, to, policy);
+        }
+
         /**
          * @brief Copy Construct a new Tree object
-         *          Runs through the tree depth first and copies every node.
+         *          Runs through the tree depth first and copies every node, so the copy has the same shape.
          *          This is used instead of "insert every element" because this way saves running time
-         *          Also has to set the first and last pointers after copying.
+         *          Big trees are copied in parallel if other uses more than one thread, see set_threads().
          *
          *          Running time: O(n)
          * @param other tree to copy.
          */
-        Tree(const Tree& other) : tree_size(other.tree_size), max_size(other.max_size), alpha(other.alpha) {
-            root = nullptr;
+        Tree(const Tree& other) : tree_size(other.tree_size), max_size(other.max_size), alpha(other.alpha), adaptive(other.adaptive),
+                                      incremental(other.incremental), pending_root(other.pending_root), pending(other.pending), threads(other.threads) {
+            root = first = last = nullptr;
             comp = other.comp;
-            if(other.root)
-                root = copy_helper(other.root);
-            auto n = root;
-            while(n->left)
-                n = n->left;
-            first = n;
-            n = root;
-            while(n->right)
-                n = n->right;
-            last = n;
+            root = copy_helper(other.root);
         }
 
         /**
          * @brief Copy Assign - overloading '='
-         *         Runs through the tree depth first and copies every node.
+         *         Runs through the tree depth first and copies every node, so the copy has the same shape.
          *         This is used instead of "insert every element" because this way saves running time
-         *          Also has to set the first and last pointers after copying.
+         *         Big trees are copied in parallel if other uses more than one thread, see set_threads().
          *
          *          Running time: O(n)
          * @param other tree to copy.
          * @return Tree& copy of tree.
          */
         Tree& operator=(const Tree& other) {
-            delete root;
-            root = nullptr;
+            if(this == &other) return *this;
+            free_nodes();
+            root = first = last = nullptr;
             tree_size = other.tree_size;
             max_size = other.max_size;
             alpha = other.alpha;
+            adaptive = other.adaptive;
+            reset_h_alpha();
+            incremental = other.incremental;
+            pending_root = other.pending_root;
+            pending = other.pending;
+            threads = other.threads;
             comp = other.comp;
-            if(other.root)
-                root = copy_helper(other.root);
-
-            auto n = root;
-            while(n->left)
-                n = n->left;
-            first = n;
-            n = root;
-            while(n->right)
-                n = n->right;
-            last = n;
+            root = copy_helper(other.root);
             return *this;
         }
 
@@ -486,16 +454,25 @@ namespace DM852 {
          * @brief Move Constructer. This tree takes ownership of other trees nodes.
          * @param other tree object.
          */
-        Tree(Tree&& other) {
+        Tree(Tree&& other) : pool(std::move(other.pool)) {
             root = other.root;
             first = other.first;
             last = other.last;
             tree_size = other.tree_size;
             max_size = other.max_size;
             alpha = other.alpha;
+            adaptive = other.adaptive;
+            reset_h_alpha();
+            incremental = other.incremental;
+            pending_root = other.pending_root;
+            pending = std::move(other.pending);
+            threads = other.threads;
+            comp = other.comp;
 
             other.root = other.first = other.last = nullptr;
             other.tree_size = other.max_size = 0;
+            other.pending_root = false;
+            other.pending.clear();
         }
 
         /**
@@ -505,16 +482,26 @@ namespace DM852 {
          */
         Tree& operator=(Tree&& other) {
             if(this == &other) return *this;
-            delete root;
+            free_nodes();
+            pool = std::move(other.pool);
             root = other.root;
             first = other.first;
             last = other.last;
             tree_size = other.tree_size;
             max_size = other.max_size;
             alpha = other.alpha;
+            adaptive = other.adaptive;
+            reset_h_alpha();
+            incremental = other.incremental;
+            pending_root = other.pending_root;
+            pending = std::move(other.pending);
+            threads = other.threads;
+            comp = other.comp;
 
             other.root = other.first = other.last = nullptr;
             other.tree_size = other.max_size = 0;
+            other.pending_root = false;
+            other.pending.clear();
             return *this;
         }
 
@@ -522,33 +509,38 @@ namespace DM852 {
          * @brief Destroy the Tree object
          */
         ~Tree() {
-            delete root;
+            free_nodes();
         }
 
         /**
          * @brief Equality comparison - overloading '=='
-         *         Goes through the tree inorder and compares every node
+         *         Walks both trees depth first at the same time and compares every node
          *         with the corresponding node in the other tree,
-         *         both their parents and key value pair.
+         *         both their children and key value pair. So the trees must also have the same shape.
+         *         The walk uses a stack instead of parent pointers.
          *
          *          Runtime: O(n)
          * @param other tree to compare with.
          * @return true if the trees are equal.
          */
-        bool operator==(const Tree& other) {
+        bool operator==(const Tree& other) const {
             if(tree_size != other.tree_size) return false;
-            auto tmp = begin();
-            for(const_iterator n = other.begin(); n != other.end(); n++) {
-                //XOR on the parents.
-                if((tmp.ptr->parent || n.ptr->parent) && (!tmp.ptr->parent || !n.ptr->parent))
-                    return false;
-                if(tmp.ptr->parent) // all node's parents must be the same
-                    if(tmp.ptr->parent->pair->first != n.ptr->parent->pair->first || tmp.ptr->parent->pair->second != n.ptr->parent->pair->second)
-                        return false;
+            std::vector<std::pair<const Node*, const Node*>> stack;
+            if(root)
+                stack.emplace_back(root, other.root);
+            while(!stack.empty()) {
+                auto [a, b] = stack.back();
+                stack.pop_back();
                 // Nodes must be the same.
-                if(tmp.ptr->pair->first != n.ptr->pair->first || tmp.ptr->pair->second != n.ptr->pair->second)
+                if(a->pair.first != b->pair.first || a->pair.second != b->pair.second)
                     return false;
-                ++tmp;
+                // XOR on the children.
+                if(!a->left != !b->left || !a->right != !b->right)
+                    return false;
+                if(a->left)
+                    stack.emplace_back(a->left, b->left);
+                if(a->right)
+                    stack.emplace_back(a->right, b->right);
             }
             return true;
         }
@@ -569,12 +561,202 @@ namespace DM852 {
             return tree_size == 0;
         }
 
+        /**
+         * @brief Smallest and biggest balance factor. Scapegoat trees need 1/2 < alpha < 1.
+         */
+        static constexpr float min_alpha = 0.51f;
+        static constexpr float max_alpha = 0.99f;
+
+        /**
+         * @brief Range the adaptive mode moves alpha in: tight_alpha for only reads, loose_alpha for only writes.
+         */
+        static constexpr float tight_alpha = 0.55f;
+        static constexpr float loose_alpha = 0.8f;
+
+        /**
+         * @brief Returns the comparator of the tree, like std::map::key_comp().
+         * @return Comp a copy of the comparator.
+         */
+        Comp key_comp() const {
+            return comp;
+        }
+
+        /**
+         * @brief Returns the balance factor alpha.
+         * @return float
+         */
+        float get_alpha() const {
+            return alpha;
+        }
+
+        /**
+         * @brief Sets the balance factor alpha, which is clamped to [min_alpha, max_alpha].
+         *          A small alpha keeps the tree shallow, which makes lookups faster, but rebuilds more often.
+         *          A big alpha rebuilds rarely, which makes inserts and erases cheaper, but the tree gets deeper.
+         *          The tree is not rebuilt right away, the new alpha is used by the next insertions and erases.
+         *
+         *          Runtime: O(1)
+         * @param a balance factor.
+         */
+        void set_alpha(float a) {
+            alpha = std::clamp(a, min_alpha, max_alpha);
+            reset_h_alpha();
+        }
+
+        /**
+         * @brief Turns the adaptive mode on or off. In adaptive mode the lookups and changes are counted,
+         *          and every adapt_period operations alpha is set between tight_alpha and loose_alpha
+         *          by the fraction of them that were lookups. Turning it off keeps the current alpha.
+         *
+         *          Runtime: O(1)
+         * @param on true to turn the adaptive mode on.
+         */
+        void set_adaptive(bool on) {
+            adaptive = on;
+            reads = 0;
+            writes = 0;
+        }
+
+        /**
+         * @return true if the adaptive mode is on.
+         */
+        bool is_adaptive() const {
+            return adaptive;
+        }
+
+        /**
+         * @brief Nodes of rebuild work done per insertion or erase in incremental mode.
+         *          Subtrees up to this size are still rebuilt at once.
+         */
+        static constexpr int rebuild_budget = 256;
+
+        /**
+         * @brief Turns the incremental mode on or off.
+         *          Normally a rebuild of a big subtree, or of the whole tree after many erases, is done
+         *          inside the insert() or erase() which triggered it, which costs O(n) for that one call.
+         *          In incremental mode only subtrees up to rebuild_budget nodes are rebuilt at once.
+         *          A bigger rebuild is split into steps: a step moves the median of a subtree up to its root
+         *          with rotations, and leaves its two halves for later steps, until the halves are small
+         *          enough to be built directly. Every insertion and erase does about rebuild_budget nodes
+         *          of the pending work, so no single call does more than O(depth + rebuild_budget) work,
+         *          where depth is the height of the tree. The tree is a valid search tree between the steps,
+         *          it is only less balanced until the work is done, so while work is pending the depth can be
+         *          more than O(log n). Once it is done the depth is O(log n) again.
+         *          Turning the mode off finishes the pending work.
+         *
+         *          Runtime: O(1), O(n) if turned off with pending work.
+         * @param on true to turn the incremental mode on.
+         */
+        void set_incremental(bool on) {
+            incremental = on;
+            if(!on)
+                finish_rebuild();
+        }
+
+        /**
+         * @return true if the incremental mode is on.
+         */
+        bool is_incremental() const {
+            return incremental;
+        }
+
+        /**
+         * @brief Subtrees and ranges smaller than this are always done by one thread.
+         */
+        static constexpr int parallel_cutoff = 1 << 14;
+
+        /**
+         * @brief Sets the number of threads used by the bulk operations: the builds of assign(), merge(),
+         *          the set operations, split(), join() and big insert_batch() calls, the copy constructer
+         *          and '=', and parallel_for_each(). The work is split fork-join style over subtrees or key
+         *          ranges of at least parallel_cutoff nodes. The other operations always use one thread.
+         *          The default is 1, which does everything on the calling thread.
+         *
+         *          Runtime: O(1)
+         * @param n number of threads, 0 for one per core.
+         */
+        void set_threads(int n) {
+            threads = std::max(n, 0);
+        }
+
+        /**
+         * @return int number of threads used by the bulk operations, see set_threads().
+         */
+        int get_threads() const {
+            return threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+        }
+
+        /**
+         * @brief Returns what the tree has done since it was made or reset_statistics() was called:
+         *          comparisons, depths of the searches, rebuilds and their sizes, time spent building, and nodes created.
+         *          Only there if the tree has a Stats policy which records, like TreeStats.
+         *          Can be called while other threads do lookups.
+         *
+         *          Runtime: O(1)
+         * @return auto the counters of the policy, TreeStats::Counters for TreeStats.
+         */
+        auto statistics() const requires Stats::enabled {
+            return stats.get();
+        }
+
+        /**
+         * @brief Sets the statistics to zero, for example after alpha was changed, see statistics().
+         *          Runtime: O(1)
+         */
+        void reset_statistics() requires Stats::enabled {
+            stats.reset();
+        }
+
+        /**
+         * @brief Calls a function for every pair. The tree is cut into one key range per thread, see set_threads(),
+         *          and every range is walked in sorted order by its own thread. The ranges are disjoint, but they
+         *          are walked at the same time, so f must be safe to call from several threads.
+         *          The function may change the values, but not the tree.
+         *
+         *          Runtime: O(n / threads + threads * log n)
+         * @param f function which is called with a value_type& for every pair.
+         */
+        template<typename F>
+        void parallel_for_each(F&& f) {
+            parallel_walk(0, tree_size, get_threads(), [&f](Node* n) {
+                f(n->pair);
+            });
+        }
+
+        /**
+         * @brief overloaded parallel_for_each() function.
+         * @param f function which is called with a const value_type& for every pair.
+         */
+        template<typename F>
+        void parallel_for_each(F&& f) const {
+            parallel_walk(0, tree_size, get_threads(), [&f](const Node* n) {
+                f(std::as_const(n->pair));
+            });
+        }
+
+        /**
+         * @return true if there is pending rebuild work, see set_incremental().
+         */
+        bool rebuilding() const {
+            return pending_root || !pending.empty();
+        }
+
+        /**
+         * @brief Does all pending rebuild work now, for example when the tree is idle.
+         *          Runtime: O(n)
+         */
+        void finish_rebuild() {
+            while(rebuilding())
+                rebuild_work(tree_size + rebuild_budget);
+        }
+
         /**
          * @brief Inserts a new node into the tree.
          *     Since it is self balancing, after the node has been inserted
          *     it will check if the node is "too deep" meaning it is not alpha weight balanced:
          *     alpha-weight-balanced if: size(left(x)) ≤ alpha * size(x) && size(right(x)) ≤ alpha * size(x).
-         *     If a node is too deep it will find the scapegoat node using parent pointers, and rebuild the tree at that node.
+         *     If a node is too deep it will find the scapegoat node among the ancestors found on the way down, and rebuild the tree at that node.
+         *     The subtree sizes are cached in the nodes, so finding the scapegoat node is O(depth).
          *     This guarentees the loosely alpha-weight-balanced property for all nodes.
          *
          *     Runtime: O_A(log n) - amortized.
@@ -583,85 +765,17 @@ namespace DM852 {
          * @return std::pair<iterator, bool> - iterator at the position of the newly inserted node, bool is true if the insertion was a sucess.
          */
         std::pair<iterator, bool> insert(const Key& key, const Value& value) {
-            Node* node = new Node(key, value);
-            Node* tmp = nullptr;
-            Node* n = root;
-            bool left_most = true;
-            bool right_most = true;
-            int depth = 0; // used later
-            while(n) {
-                tmp = n;
-                depth++;
-                if (comp(node->pair->first, n->pair->first)) {
-                    n = n->left;
-                    right_most = false;
-                }
-                else if (!comp(node->pair->first, n->pair->first) && !comp(n->pair->first, node->pair->first)) { //node with key already exists
-                    bool res_bool = false;
-                    if(node->pair->second != n->pair->second) { //update value of node
-                        n->pair->second = value;
-                        res_bool = true;
-                    }
-                    delete node;
-                    auto it = iterator(*this, n);
-                    return std::make_pair(it, res_bool);
-                }
-                else {
-                    n = n->right;
-                    left_most = false;
-                }
-            }
-            node->parent = tmp;
-            if(!tmp)
-                root = node;
-            else if(comp(node->pair->first, tmp->pair->first))
-                tmp->left = node;
-            else
-                tmp->right = node;
-            tree_size++;
-            max_size = std::max(max_size, tree_size);
-
-            if(left_most)
-                first = node;
-            if(right_most)
-                last = node;
-            auto iter = iterator(*this, node);
-            /* Self balancing part: */
-            //Check if inserted node is too deep:
-            if(depth > h_alpha() && tree_size > 2) {
-                //Find scapegoat node:
-                Node* tmp = node;
-                while(tmp->parent != nullptr) {
-                    Node* scn = tmp->parent;
-                    int n_size = node_size(scn);
-                    // Check if node is scapegoat candidate:
-                    if(!(node_size(scn->left) <= alpha * n_size && node_size(scn->right) <= alpha * n_size)) {
-                        Node* w = new Node(Key(), Value());
-                        if(scn->parent == nullptr) { //root is scapegoat node, rebuild whole tree
-                            root = flatten_wrapper(root, w);
-                            root = build(n_size, root)->left;
-                            max_size = tree_size;
-                            w->left = nullptr;
-                            delete w;
-                            return std::make_pair(iter, true);
-                        }
-                        Node* scn_parent = scn->parent; // Remember the parent of the scapegoat node
-                        Node* z = flatten_wrapper(scn, w);
-                        scn = build(n_size, z)->left;
-                        scn->parent = scn_parent;
-                        if(comp(scn->pair->first, scn_parent->pair->first)) // left child
-                            scn_parent->left = scn;
-                        else                       // right right
-                            scn_parent->right = scn;
-                        max_size = tree_size;
-                        w->left = nullptr;
-                        delete w;
-                        return std::make_pair(iter, true);
-                    }
-                    tmp = tmp->parent;
+            Position pos = locate(key);
+            if(pos.node) { //node with key already exists
+                bool res_bool = false;
+                if(pos.node->pair.second != value) { //update value of node
+                    pos.node->pair.second = value;
+                    res_bool = true;
                 }
+                return std::make_pair(iterator(*this, pos.node), res_bool);
             }
-            return std::make_pair(iter, true);
+            Node* node = link(create_node(key, value), pos);
+            return std::make_pair(iterator(*this, node), true);
         }
 
         /**
@@ -671,245 +785,822 @@ namespace DM852 {
          * @return std::pair<iterator, bool> - iterator at the position of the newly inserted node, bool is true if the insertion was a sucess.
          */
         std::pair<iterator, bool> insert(Key&& key, Value&& value) {
-            Node* node = new Node(key, value);
-            Node* tmp = nullptr;
-            Node* n = root;
-            bool left_most = true;
-            bool right_most = true;
-            int depth = 0; // used later
-            while(n) {
-                tmp = n;
-                depth++;
-                if (comp(node->pair->first, n->pair->first)) {
-                    n = n->left;
-                    right_most = false;
-                }
-                else if (!comp(node->pair->first, n->pair->first) && !comp(n->pair->first, node->pair->first)) { //node with key already exists
-                    bool res_bool = false;
-                    if(node->pair->second != n->pair->second) { //update value of node
-                        n->pair->second = value;
-                        res_bool = true;
-                    }
-                    delete node;
-                    auto it = iterator(*this, n);
-                    return std::make_pair(it, res_bool);
-                }
-                else {
-                    n = n->right;
-                    left_most = false;
+            Position pos = locate(key);
+            if(pos.node) { //node with key already exists
+                bool res_bool = false;
+                if(pos.node->pair.second != value) { //update value of node
+                    pos.node->pair.second = std::move(value);
+                    res_bool = true;
                 }
+                return std::make_pair(iterator(*this, pos.node), res_bool);
             }
-            node->parent = tmp;
-            if(!tmp)
-                root = node;
-            else if(comp(node->pair->first, tmp->pair->first))
-                tmp->left = node;
-            else
-                tmp->right = node;
-            tree_size++;
-            max_size = std::max(max_size, tree_size);
-
-            if(left_most)
-                first = node;
-            if(right_most)
-                last = node;
-            auto iter = iterator(*this, node);
-            /* Self balancing part: */
-            //Check if inserted node is too deep:
-            if(depth > h_alpha() && tree_size > 2) {
-                //Find scapegoat node:
-                Node* tmp = node;
-                while(tmp->parent != nullptr) {
-                    Node* scn = tmp->parent;
-                    int n_size = node_size(scn);
-                    // Check if node is scapegoat candidate:
-                    if(!(node_size(scn->left) <= alpha * n_size && node_size(scn->right) <= alpha * n_size)) {
-                        Node* w = new Node(Key(), Value());
-                        if(scn->parent == nullptr) { //root is scapegoat node, rebuild whole tree
-                            root = flatten_wrapper(root, w);
-                            root = build(n_size, root)->left;
-                            max_size = tree_size;
-                            w->left = nullptr;
-                            delete w;
-                            return std::make_pair(iter, true);
-                        }
-                        Node* scn_parent = scn->parent; // Remember the parent of the scapegoat node
-                        Node* z = flatten_wrapper(scn, w);
-                        scn = build(n_size, z)->left;
-                        scn->parent = scn_parent;
-                        if(comp(scn->pair->first, scn_parent->pair->first)) // left child
-                            scn_parent->left = scn;
-                        else                       // right right
-                            scn_parent->right = scn;
-                        max_size = tree_size;
-                        w->left = nullptr;
-                        delete w;
-                        return std::make_pair(iter, true);
-                    }
-                    tmp = tmp->parent;
-                }
-            }
-            return std::make_pair(iter, true);
+            Node* node = link(create_node(std::move(key), std::move(value)), pos);
+            return std::make_pair(iterator(*this, node), true);
         }
 
         /**
-         * @brief Finds a node given a key.
-         *        Runtime: O(log n)
+         * @brief Inserts a value constructed in place from the arguments, if its key is not in the tree.
+         *          The node has to be constructed before the key is known, but it is made in a pool slot,
+         *          so a duplicate only costs constructing and destroying the pair, not an allocation.
+         *          Use try_emplace() when the key is known, it searches first.
          *
-         * @param key to find
-         * @return iterator at the position to the found node. past the end iterator if not found.
+         *          Runtime: O_A(log n) - amortized.
+         * @param args arguments forwarded to the constructer of value_type.
+         * @return std::pair<iterator, bool> - iterator at the node with the key, bool is true if the node was inserted.
          */
-        iterator find(const Key& key) {
-            auto tmp = root;
-            while(tmp && tmp->pair->first != key) {
-                if(comp(key, tmp->pair->first))
-                    tmp = tmp->left;
-                else
-                    tmp = tmp->right;
+        template<typename... Args>
+        std::pair<iterator, bool> emplace(Args&&... args) {
+            Node* node = create_node(std::forward<Args>(args)...);
+            Position pos = locate(node->pair.first);
+            if(pos.node) {
+                pool.destroy(node);
+                return std::make_pair(iterator(*this, pos.node), false);
             }
-            if(tmp == nullptr)
-                return end();
-            return iterator(*this, tmp);
+            link(node, pos);
+            return std::make_pair(iterator(*this, node), true);
         }
 
         /**
-         * @brief overloaded find() function.
-         * @param key to find
-         * @return const_iterator at the position to the found node. past the end iterator if not found.
+         * @brief Inserts a node with the key and a value constructed in place from the arguments,
+         *          if the key is not in the tree. Nothing is constructed if the key exists.
+         *
+         *          Runtime: O_A(log n) - amortized.
+         * @param key of the node.
+         * @param args arguments forwarded to the constructer of Value.
+         * @return std::pair<iterator, bool> - iterator at the node with the key, bool is true if the node was inserted.
          */
-        const_iterator find(const Key& key) const {
-            auto tmp = root;
-            while(tmp && tmp->pair->first != key) {
-                if(comp(key, tmp->pair->first))
-                    tmp = tmp->left;
-                else
-                    tmp = tmp->right;
-            }
-            if(tmp == nullptr)
-                return end();
-            return const_iterator(*this, tmp);
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(const Key& key, Args&&... args) {
+            Position pos = locate(key);
+            if(pos.node)
+                return std::make_pair(iterator(*this, pos.node), false);
+            Node* node = link(create_node(std::piecewise_construct, std::forward_as_tuple(key),
+                                          std::forward_as_tuple(std::forward<Args>(args)...)), pos);
+            return std::make_pair(iterator(*this, node), true);
         }
 
         /**
-         * @brief Deletes all nodes and sets root to nullptr.
-         *
-         *          Runtime: O(n)
+         * @brief Overloaded try_emplace(), but moves the key into the node.
+         * @param key rvalue key of the node.
+         * @param args arguments forwarded to the constructer of Value.
+         * @return std::pair<iterator, bool> - iterator at the node with the key, bool is true if the node was inserted.
          */
-        void clear() {
-            delete root;
-            first = last = root = nullptr;
-            tree_size = 0;
-            max_size = 0;
+        template<typename... Args>
+        std::pair<iterator, bool> try_emplace(Key&& key, Args&&... args) {
+            Position pos = locate(key);
+            if(pos.node)
+                return std::make_pair(iterator(*this, pos.node), false);
+            Node* node = link(create_node(std::piecewise_construct, std::forward_as_tuple(std::move(key)),
+                                          std::forward_as_tuple(std::forward<Args>(args)...)), pos);
+            return std::make_pair(iterator(*this, node), true);
         }
 
         /**
-         * @brief Removes a node given the key.
-         *        Follows the pseudo-code in Introduction to Algorithms from Cormen et al. chapter 12 p.298
-         *        case 1: z has no left child -> replace z with right child
-         *                  if right child is null z is leaf
-         *        case 2: z only has a left child -> replace z with left child.
-         *        case 3: find z's successor and replace z with that.
+         * @brief Assigns the value to the node with the key, or inserts a new node if the key is not in the tree.
+         *          Unlike insert() the value is assigned without comparing it to the old value first.
          *
-         *        Runtime: O_A(log n) - amortized
-         * @param key of node to remove.
+         *          Runtime: O_A(log n) - amortized.
+         * @param key of the node.
+         * @param value to assign or insert.
+         * @return std::pair<iterator, bool> - iterator at the node with the key, bool is true if the node was inserted.
          */
-        void erase(const Key& key) {
-            auto pos = find(key);
-            erase(pos);
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(const Key& key, M&& value) {
+            Position pos = locate(key);
+            if(pos.node) {
+                pos.node->pair.second = std::forward<M>(value);
+                return std::make_pair(iterator(*this, pos.node), false);
+            }
+            Node* node = link(create_node(key, std::forward<M>(value)), pos);
+            return std::make_pair(iterator(*this, node), true);
         }
 
         /**
-         * @brief Same implementation as erase(int key)
-         *        Doesn't need to find the node first
-         *        Runtime: O_A(log n) - amortized
-         * @param const_iterator position of the node to remove.
+         * @brief Overloaded insert_or_assign(), but moves the key into the node.
+         * @param key rvalue key of the node.
+         * @param value to assign or insert.
+         * @return std::pair<iterator, bool> - iterator at the node with the key, bool is true if the node was inserted.
          */
-        void erase(const_iterator pos) {
-            auto* node = const_cast<Node*>(pos.ptr);
-            if(first == node) // deleting the first node
-                first = node->next();
-            if(last == node) // deleting the last node
-                last = node->prev();
-            if(node->left == nullptr) {
-                subtree_shift(node, node->right);
-            } else if (node->right == nullptr){
-                subtree_shift(node, node->left);
-            } else {
-                auto y = node->next();
-                if(y->parent != node) {
-                    subtree_shift(y, y->right);
-                    y->right = node->right;
-                    y->right->parent = y;
-                }
-                subtree_shift(node, y);
-                y->left = node->left;
-                y->left->parent = y;
+        template<typename M>
+        std::pair<iterator, bool> insert_or_assign(Key&& key, M&& value) {
+            Position pos = locate(key);
+            if(pos.node) {
+                pos.node->pair.second = std::forward<M>(value);
+                return std::make_pair(iterator(*this, pos.node), false);
             }
-            tree_size--;
-            node->left = node->right = nullptr;
-            delete node;
+            Node* node = link(create_node(std::move(key), std::forward<M>(value)), pos);
+            return std::make_pair(iterator(*this, node), true);
+        }
 
-            //rebuild tree at root if too unbalanced.
-            if(tree_size < alpha * max_size) {
-                Node* w = new Node(Key(), Value());
-                root = flatten_wrapper(root, w);
-                root = build(tree_size, root)->left;
-                max_size = tree_size;
-                w->left = nullptr;
-                delete w;
+        /**
+         * @brief Replaces the content of the tree with a sorted range of key value pairs.
+         *          The nodes are linked together in a list and the tree is made with a single build(),
+         *          so there are no searches and no rebalancing while loading.
+         *          If an element is out of order, the sorted part is built and the rest
+         *          of the range is inserted one at a time, so the result is always correct.
+         *
+         *          Runtime: O(n) if the range is sorted, else O(n log n) - amortized.
+         * @param from iterator to the first pair.
+         * @param to past the end iterator of the range.
+         * @param policy which value to keep for equal keys.
+         */
+        template<typename InputIt>
+        void assign(InputIt from, InputIt to, duplicates policy = duplicates::keep_last) {
+            clear();
+            Node* tail = nullptr;
+            int n = 0;
+            for(; from != to; ++from) {
+                const auto& elem = *from;
+                if(tail && !comp(tail->pair.first, elem.first)) {
+                    if(comp(elem.first, tail->pair.first)) // out of order
+                        break;
+                    if(policy == duplicates::keep_last)
+                        tail->pair.second = elem.second;
+                    continue;
+                }
+                append(create_node(elem.first, elem.second), tail);
+                n++;
+            }
+            build_list(n, tail);
+            for(; from != to; ++from) { // the range was not sorted
+                const auto& elem = *from;
+                if(policy == duplicates::keep_first && find(elem.first) != end())
+                    continue;
+                insert(elem.first, elem.second);
             }
         }
 
-         /**
-         * @brief The leftmost node.
-         * @return value_type& value of the leftmost node.
-         *          Past the end iterator if tree is empty.
+        /**
+         * @brief Moves the nodes of other whose keys are not in this tree into this tree, like std::map::merge().
+         *          The sorted lists of both trees are merged and both trees are built again with build().
+         *          The memory of other is taken over by this pool, so the moved nodes are not copied.
+         *          The nodes which stay in other are moved into new nodes in the pool of other,
+         *          so iterators to them are invalidated.
+         *
+         *          Runtime: O(n + m)
+         * @param other tree to take the nodes from.
          */
-        value_type& front() {
-            return *(begin());
+        void merge(Tree& other) {
+            if(this == &other) return;
+            pool.splice(other.pool);
+            Node* cur = first;
+            Node* o = other.first;
+            first = other.first = nullptr;
+            Node* tail = nullptr;
+            Node* other_tail = nullptr;
+            int n = 0, other_n = 0;
+            while(cur || o) {
+                Node* take;
+                if(!o || (cur && comp(cur->pair.first, o->pair.first))) {
+                    take = cur;
+                    cur = cur->succ;
+                } else if(cur && !comp(o->pair.first, cur->pair.first)) { // key in both, the node of other stays
+                    take = cur;
+                    cur = cur->succ;
+                    Node* stay = o;
+                    o = o->succ;
+                    other.append(other.create_node(stay->pair.first, std::move(stay->pair.second)), other_tail);
+                    other_n++;
+                    pool.destroy(stay);
+                } else {
+                    take = o;
+                    o = o->succ;
+                }
+                append(take, tail);
+                n++;
+            }
+            build_list(n, tail);
+            other.build_list(other_n, other_tail);
         }
 
         /**
-         * @brief The leftmost node.
-         * @return const value_type& value of the leftmost node.
-         *          Past the end const_iterator if tree is empty.
+         * @brief Overloaded merge(), for a temporary tree.
+         * @param other tree to take the nodes from.
          */
-        const value_type& front() const {
-            return *(begin());
+        void merge(Tree&& other) {
+            merge(other);
         }
 
         /**
-         * @brief The rightmost node.
-         * @return value_type& value of the rightmost node.
-         *          Past the end iterator if tree is empty.
+         * @brief Makes this tree the union of itself and other.
+         *          The sorted lists of both trees are merged and the tree is built again with build(),
+         *          so only the keys that are new get a node, and there is no search or rebalancing.
+         *
+         *          Runtime: O(n + m)
+         * @param other tree to add.
+         * @param policy keep_first keeps the values of this tree for equal keys, keep_last takes the values of other,
+         *          which is the same as inserting every pair of other with insert().
          */
-        value_type& back() {
-            if(empty()) end();
-            return *(--end());
+        void set_union(const Tree& other, duplicates policy = duplicates::keep_last) {
+            if(this == &other) return;
+            Node* cur = first;
+            const Node* o = other.first;
+            first = nullptr;
+            Node* tail = nullptr;
+            int n = 0;
+            while(cur || o) {
+                Node* take;
+                if(!o || (cur && comp(cur->pair.first, o->pair.first))) {
+                    take = cur;
+                    cur = cur->succ;
+                } else if(cur && !comp(o->pair.first, cur->pair.first)) { // key in both
+                    if(policy == duplicates::keep_last)
+                        cur->pair.second = o->pair.second;
+                    take = cur;
+                    cur = cur->succ;
+                    o = o->succ;
+                } else {
+                    take = create_node(o->pair.first, o->pair.second);
+                    o = o->succ;
+                }
+                append(take, tail);
+                n++;
+            }
+            build_list(n, tail);
         }
 
         /**
-         * @brief The rightmost node.
-         * @return const value_type& value of the rightmost node.
-         *          Past the end const_iterator if tree is empty.
+         * @brief Overloaded set_union(), which takes the nodes of a temporary tree instead of copying them.
+         *          The memory of other is taken over by this pool. other is empty afterwards.
+         *
+         *          Runtime: O(n + m)
+         * @param other tree to add.
+         * @param policy which value to keep for equal keys, see set_union().
          */
-        const value_type& back() const {
-            if(empty()) end();
-            return *(--end());
+        void set_union(Tree&& other, duplicates policy = duplicates::keep_last) {
+            if(this == &other) return;
+            pool.splice(other.pool);
+            Node* cur = first;
+            Node* o = other.first;
+            first = nullptr;
+            Node* tail = nullptr;
+            int n = 0;
+            while(cur || o) {
+                Node* take;
+                if(!o || (cur && comp(cur->pair.first, o->pair.first))) {
+                    take = cur;
+                    cur = cur->succ;
+                } else if(cur && !comp(o->pair.first, cur->pair.first)) { // key in both, one of the nodes goes
+                    Node* drop = cur;
+                    take = o;
+                    if(policy == duplicates::keep_first)
+                        std::swap(take, drop);
+                    cur = cur->succ;
+                    o = o->succ;
+                    pool.destroy(drop);
+                } else {
+                    take = o;
+                    o = o->succ;
+                }
+                append(take, tail);
+                n++;
+            }
+            build_list(n, tail);
+            other.first = nullptr;
+            other.build_list(0, nullptr);
         }
 
         /**
-         * @return iterator at the position of the leftmost node.
-         *          Past the end iterator if tree is empty.
+         * @brief Removes the nodes whose keys are not in other. The values of this tree are kept.
+         *          The lists of both trees are walked together, and the tree is built again with build().
+         *
+         *          Runtime: O(n + m)
+         * @param other tree with the keys to keep.
          */
-        iterator begin() {
-            if(empty()) return end();
-            return iterator(*this, first);
+        void set_intersection(const Tree& other) {
+            if(this == &other) return;
+            Node* cur = first;
+            const Node* o = other.first;
+            first = nullptr;
+            Node* tail = nullptr;
+            int n = 0;
+            while(cur) {
+                while(o && comp(o->pair.first, cur->pair.first))
+                    o = o->succ;
+                Node* next = cur->succ;
+                if(o && !comp(cur->pair.first, o->pair.first)) {
+                    append(cur, tail);
+                    n++;
+                    o = o->succ;
+                } else
+                    pool.destroy(cur);
+                cur = next;
+            }
+            build_list(n, tail);
         }
 
         /**
-         * @return const_iterator at the position of the leftmost node.
-         *          Past the end const_iterator if tree is empty.
+         * @brief Removes the nodes whose keys are in other.
+         *          The lists of both trees are walked together, and the tree is built again with build().
+         *
+         *          Runtime: O(n + m)
+         * @param other tree with the keys to remove.
+         */
+        void set_difference(const Tree& other) {
+            if(this == &other) {
+                clear();
+                return;
+            }
+            Node* cur = first;
+            const Node* o = other.first;
+            first = nullptr;
+            Node* tail = nullptr;
+            int n = 0;
+            while(cur) {
+                while(o && comp(o->pair.first, cur->pair.first))
+                    o = o->succ;
+                Node* next = cur->succ;
+                if(o && !comp(cur->pair.first, o->pair.first))
+                    pool.destroy(cur);
+                else {
+                    append(cur, tail);
+                    n++;
+                }
+                cur = next;
+            }
+            build_list(n, tail);
+        }
+
+        /**
+         * @brief Cuts the tree in two. This tree keeps the keys smaller than key, and the rest is returned.
+         *          The sorted list is cut at the lower bound of key, and both halves are built again with build().
+         *          The bigger half keeps its nodes and the pool, and the smaller half is moved into new nodes
+         *          in the other pool, since every tree has its own pool. So dropping a small slice of old
+         *          keys only touches the slice, besides the build of the rest.
+         *          Iterators to the smaller half are invalidated.
+         *
+         *          Runtime: O(n)
+         * @param key first key of the returned tree, it does not have to be in the tree.
+         * @return Tree with the keys not smaller than key, with the same alpha and modes as this tree.
+         */
+        Tree split(const Key& key) {
+            Tree res(alpha, comp);
+            res.adaptive = adaptive;
+            res.incremental = incremental;
+            res.threads = threads;
+            int k = rank(key);
+            int m = tree_size - k;
+            Node* mid = bound_node(key, false);
+            Node* left_tail = mid ? mid->pred : last;
+            Node* right_last = mid ? last : nullptr;
+            if(left_tail)
+                left_tail->succ = nullptr;
+            if(mid)
+                mid->pred = nullptr;
+            if(k >= m) { // this tree keeps its nodes
+                if(k == 0)
+                    first = nullptr;
+                res.first = nullptr;
+                Node* tail = nullptr;
+                for(Node* n = mid; n;) {
+                    Node* next = n->succ;
+                    res.append(res.create_node(n->pair.first, std::move(n->pair.second)), tail);
+                    pool.destroy(n);
+                    n = next;
+                }
+                res.build_list(m, tail);
+                build_list(k, left_tail);
+            } else { // the returned tree takes the nodes and the pool
+                res.pool = std::move(pool);
+                res.first = mid;
+                res.build_list(m, right_last);
+                Node* n = k > 0 ? first : nullptr;
+                first = nullptr;
+                Node* tail = nullptr;
+                while(n) {
+                    Node* next = n->succ;
+                    append(create_node(n->pair.first, std::move(n->pair.second)), tail);
+                    res.pool.destroy(n);
+                    n = next;
+                }
+                build_list(k, tail);
+            }
+            return res;
+        }
+
+        /**
+         * @brief Joins two trees, where every key of left is smaller than every key of right.
+         *          The sorted lists are linked together and the tree is built again with build().
+         *          The pool of right is taken over, so no node is copied and no key is compared.
+         *          If the keys overlap, the trees are merged with set_union() instead, so the result is always correct.
+         *
+         *          Runtime: O(n + m)
+         * @param left tree with the small keys, its alpha and modes are kept.
+         * @param right tree with the big keys. Both trees are empty afterwards.
+         * @return Tree with the nodes of both trees.
+         */
+        static Tree join(Tree&& left, Tree&& right) {
+            Tree res(std::move(left));
+            if(res.last && right.first && !res.comp(res.last->pair.first, right.first->pair.first)) {
+                res.set_union(std::move(right));
+                return res;
+            }
+            res.pool.splice(right.pool);
+            int n = res.tree_size + right.tree_size;
+            Node* tail = right.last ? right.last : res.last;
+            if(res.last)
+                res.last->succ = right.first;
+            else
+                res.first = right.first;
+            if(right.first)
+                right.first->pred = res.last;
+            res.build_list(n, tail);
+            right.first = nullptr;
+            right.build_list(0, nullptr);
+            return res;
+        }
+
+        /**
+         * @brief Finds a node given a key.
+         *        Uses one comparison per level, see find_node().
+         *        Runtime: O(log n)
+         *
+         * @param key to find
+         * @return iterator at the position to the found node. past the end iterator if not found.
+         */
+        iterator find(const Key& key) {
+            return iterator(*this, find_node(key));
+        }
+
+        /**
+         * @brief overloaded find() function.
+         * @param key to find
+         * @return const_iterator at the position to the found node. past the end iterator if not found.
+         */
+        const_iterator find(const Key& key) const {
+            return const_iterator(*this, find_node(key));
+        }
+
+        /**
+         * @brief Inserts a batch of key value pairs.
+         *          The batch is sorted first. If it is big compared to the tree, the sorted list of nodes
+         *          is merged with the batch and the tree is built again in one pass.
+         *          Otherwise the keys are inserted in order, and each search starts from the lowest node
+         *          on the previous search path which can contain the key, so neighbouring keys share the top of their descent. The scapegoat check
+         *          is done once for the whole batch, instead of rebuilding the same subtree for every key.
+         *          Equal keys behave like calling insert() in order, so the last value wins.
+         *
+         *          Runtime: O(k log k + min(n + k, k log n)) - amortized, k is the size of the batch.
+         * @param from iterator to the first pair.
+         * @param to past the end iterator of the batch.
+         * @return int number of keys that were not in the tree before.
+         */
+        template<typename InputIt>
+        int insert_batch(InputIt from, InputIt to) {
+            std::vector<std::pair<Key, Value>> batch;
+            for(; from != to; ++from)
+                batch.emplace_back((*from).first, (*from).second);
+            std::stable_sort(batch.begin(), batch.end(), [this](const auto& a, const auto& b) {
+                return comp(a.first, b.first);
+            });
+            size_t k = 0; // remove equal keys, the last one wins
+            for(size_t i = 0; i < batch.size(); i++) {
+                if(k > 0 && !comp(batch[k-1].first, batch[i].first)) {
+                    batch[k-1].second = std::move(batch[i].second);
+                } else {
+                    if(k != i)
+                        batch[k] = std::move(batch[i]);
+                    k++;
+                }
+            }
+            batch.erase(batch.begin() + k, batch.end());
+            if(batch.empty()) return 0;
+            // merging costs O(n + k) and searching O(k log n), so merge once k log(n+1) >= n
+            if(batch.size() * size_t(std::bit_width(unsigned(tree_size) + 1)) >= size_t(tree_size))
+                return merge_batch(batch);
+
+            int inserted = 0;
+            std::vector<Node*> deep; // inserted nodes that were too deep
+            path.clear();
+            for(auto& elem : batch) {
+                Node* n = root;
+                if(!path.empty()) { // start from the lowest node on the previous path which can contain the key
+                    climb(path, elem.first);
+                    n = path.back();
+                    path.pop_back();
+                }
+                int c = 0;
+                while(n) {
+                    path.push_back(n);
+                    c = compare(elem.first, n->pair.first);
+                    if(c == 0)
+                        break;
+                    n = c < 0 ? n->left : n->right;
+                }
+                if(n) { // key already exists
+                    n->pair.second = std::move(elem.second);
+                    continue;
+                }
+                Node* node = attach(create_node(std::move(elem.first), std::move(elem.second)), c);
+                inserted++;
+                note_write();
+                if(int(path.size()) > h_alpha())
+                    deep.push_back(node);
+                path.push_back(node);
+            }
+            for(Node* node : deep) { // earlier rebuilds may have fixed the later nodes already
+                locate(node->pair.first);
+                path.pop_back(); // the node itself
+                rebalance();
+            }
+            return inserted;
+        }
+
+        /**
+         * @brief Finds a batch of keys.
+         *          The keys are searched in sorted order, and each search starts from the
+         *          position of the previous one, so neighbouring keys share the top of their descent.
+         *          The results are written in the same order as the keys.
+         *
+         *          Runtime: O(k log k + k log n), k is the number of keys.
+         * @param from iterator to the first key.
+         * @param to past the end iterator of the keys.
+         * @param out output iterator which gets an iterator for every key, past the end iterator if not found.
+         * @return OutputIt past the last written result.
+         */
+        template<typename InputIt, typename OutputIt>
+        OutputIt find_batch(InputIt from, InputIt to, OutputIt out) {
+            for(Node* n : find_batch_nodes(from, to))
+                *out++ = iterator(*this, n);
+            return out;
+        }
+
+        /**
+         * @brief overloaded find_batch() function.
+         * @param from iterator to the first key.
+         * @param to past the end iterator of the keys.
+         * @param out output iterator which gets a const_iterator for every key, past the end const_iterator if not found.
+         * @return OutputIt past the last written result.
+         */
+        template<typename InputIt, typename OutputIt>
+        OutputIt find_batch(InputIt from, InputIt to, OutputIt out) const {
+            for(Node* n : find_batch_nodes(from, to))
+                *out++ = const_iterator(*this, n);
+            return out;
+        }
+
+        /**
+         * @brief Finds the first node whose key is not smaller than key.
+         *          Runtime: O(log n)
+         *
+         * @param key to search for, it does not have to be in the tree.
+         * @return iterator at the found node. past the end iterator if there is none.
+         */
+        iterator lower_bound(const Key& key) {
+            return iterator(*this, bound_node(key, false));
+        }
+
+        /**
+         * @brief overloaded lower_bound() function.
+         * @param key to search for, it does not have to be in the tree.
+         * @return const_iterator at the found node. past the end const_iterator if there is none.
+         */
+        const_iterator lower_bound(const Key& key) const {
+            return const_iterator(*this, bound_node(key, false));
+        }
+
+        /**
+         * @brief Finds the first node whose key is bigger than key.
+         *          Runtime: O(log n)
+         *
+         * @param key to search for, it does not have to be in the tree.
+         * @return iterator at the found node. past the end iterator if there is none.
+         */
+        iterator upper_bound(const Key& key) {
+            return iterator(*this, bound_node(key, true));
+        }
+
+        /**
+         * @brief overloaded upper_bound() function.
+         * @param key to search for, it does not have to be in the tree.
+         * @return const_iterator at the found node. past the end const_iterator if there is none.
+         */
+        const_iterator upper_bound(const Key& key) const {
+            return const_iterator(*this, bound_node(key, true));
+        }
+
+        /**
+         * @brief Finds the range of nodes with the key. Because keys are unique it is empty or has one node.
+         *          Runtime: O(log n)
+         *
+         * @param key to search for.
+         * @return std::pair<iterator, iterator> - lower_bound(key) and upper_bound(key).
+         */
+        std::pair<iterator, iterator> equal_range(const Key& key) {
+            iterator lo = lower_bound(key);
+            iterator hi = lo;
+            if(hi != end() && !comp(key, hi->first)) // the key is in the tree
+                ++hi;
+            return std::make_pair(lo, hi);
+        }
+
+        /**
+         * @brief overloaded equal_range() function.
+         * @param key to search for.
+         * @return std::pair<const_iterator, const_iterator> - lower_bound(key) and upper_bound(key).
+         */
+        std::pair<const_iterator, const_iterator> equal_range(const Key& key) const {
+            const_iterator lo = lower_bound(key);
+            const_iterator hi = lo;
+            if(hi != end() && !comp(key, hi->first))
+                ++hi;
+            return std::make_pair(lo, hi);
+        }
+
+        /**
+         * @brief A lazy view of the nodes with keys in [lo, hi).
+         *          Only the two ends are searched for, the nodes are visited when the view is iterated,
+         *          so a scan over k nodes costs O(log n + k). It works with range based for loops
+         *          and the std::ranges algorithms and views. Like any iterator, the view is
+         *          invalidated by changes to the tree.
+         *          Runtime: O(log n)
+         *
+         * @param lo smallest key of the range.
+         * @param hi the first key after the range.
+         * @return std::ranges::subrange<iterator> the view, empty if hi is not bigger than lo.
+         */
+        std::ranges::subrange<iterator> range(const Key& lo, const Key& hi) {
+            iterator from = lower_bound(lo);
+            if(!comp(lo, hi))
+                return std::ranges::subrange<iterator>(from, from);
+            return std::ranges::subrange<iterator>(from, lower_bound(hi));
+        }
+
+        /**
+         * @brief overloaded range() function.
+         * @param lo smallest key of the range.
+         * @param hi the first key after the range.
+         * @return std::ranges::subrange<const_iterator> the view, empty if hi is not bigger than lo.
+         */
+        std::ranges::subrange<const_iterator> range(const Key& lo, const Key& hi) const {
+            const_iterator from = lower_bound(lo);
+            if(!comp(lo, hi))
+                return std::ranges::subrange<const_iterator>(from, from);
+            return std::ranges::subrange<const_iterator>(from, lower_bound(hi));
+        }
+
+        /**
+         * @brief Finds the k-th smallest node, counting from 0.
+         *          Uses the subtree sizes, so only one path from the root is visited.
+         *          Runtime: O(log n)
+         *
+         * @param k position of the node in sorted order.
+         * @return iterator at the k-th node. past the end iterator if k is not in [0, size()).
+         */
+        iterator select(int k) {
+            return iterator(*this, select_node(k));
+        }
+
+        /**
+         * @brief overloaded select() function.
+         * @param k position of the node in sorted order.
+         * @return const_iterator at the k-th node. past the end const_iterator if k is not in [0, size()).
+         */
+        const_iterator select(int k) const {
+            return const_iterator(*this, select_node(k));
+        }
+
+        /**
+         * @brief Counts the keys which are smaller than key.
+         *          If the key is in the tree, this is its position in sorted order, so select(rank(key)) finds it.
+         *          Runtime: O(log n)
+         *
+         * @param key to rank, it does not have to be in the tree.
+         * @return int number of smaller keys.
+         */
+        int rank(const Key& key) const {
+            int res = 0;
+            Node* n = root;
+            while(n) {
+                if(comp(n->pair.first, key)) { // n and its left subtree are smaller
+                    res += node_size(n->left) + 1;
+                    n = n->right;
+                } else
+                    n = n->left;
+            }
+            return res;
+        }
+
+        /**
+         * @brief Counts the keys in the range [lo, hi).
+         *          Runtime: O(log n)
+         *
+         * @param lo smallest key of the range.
+         * @param hi the first key after the range.
+         * @return int number of keys in the range, 0 if hi is not bigger than lo.
+         */
+        int count_range(const Key& lo, const Key& hi) const {
+            if(!comp(lo, hi))
+                return 0;
+            return rank(hi) - rank(lo);
+        }
+
+        /**
+         * @brief Destroys all nodes and sets root to nullptr.
+         *          The memory blocks of the nodes are kept, so the tree can be refilled without allocating.
+         *
+         *          Runtime: O(n), O(1) if the key and value are trivially destructible.
+         */
+        void clear() {
+            free_nodes();
+            first = last = root = nullptr;
+            tree_size = 0;
+            max_size = 0;
+            pending_root = false;
+            pending.clear();
+        }
+
+        /**
+         * @brief Removes a node given the key.
+         *        Follows the pseudo-code in Introduction to Algorithms from Cormen et al. chapter 12 p.298
+         *        case 1: z has no left child -> replace z with right child
+         *                  if right child is null z is leaf
+         *        case 2: z only has a left child -> replace z with left child.
+         *        case 3: find z's successor and replace z with that.
+         *
+         *        Does nothing if the key is not in the tree.
+         *
+         *        Runtime: O_A(log n) - amortized
+         * @param key of node to remove.
+         */
+        void erase(const Key& key) {
+            if(locate(key).node)
+                erase_located();
+        }
+
+        /**
+         * @brief Same implementation as erase(int key)
+         *        The node has no parent pointer, so its ancestors are found by searching for its key.
+         *        Runtime: O_A(log n) - amortized
+         * @param const_iterator position of the node to remove.
+         */
+        void erase(const_iterator pos) {
+            locate(pos.ptr->pair.first);
+            erase_located();
+        }
+
+        /**
+         * @brief Makes an immutable snapshot of the tree in a contiguous, cache friendly layout.
+         *          Lookups in the snapshot do not follow pointers, so they are faster than
+         *          find() for read mostly data. Later changes to the tree are not seen by the snapshot.
+         *
+         *          Runtime: O(n)
+         * @return FrozenTree<Key, Value, Comp> the snapshot.
+         */
+        FrozenTree<Key, Value, Comp> freeze() const {
+            return FrozenTree<Key, Value, Comp>(begin(), end(), comp);
+        }
+
+         /**
+         * @brief The leftmost node.
+         * @return value_type& value of the leftmost node.
+         *          Past the end iterator if tree is empty.
+         */
+        value_type& front() {
+            return *(begin());
+        }
+
+        /**
+         * @brief The leftmost node.
+         * @return const value_type& value of the leftmost node.
+         *          Past the end const_iterator if tree is empty.
+         */
+        const value_type& front() const {
+            return *(begin());
+        }
+
+        /**
+         * @brief The rightmost node.
+         * @return value_type& value of the rightmost node.
+         *          Past the end iterator if tree is empty.
+         */
+        value_type& back() {
+            if(empty()) end();
+            return *(--end());
+        }
+
+        /**
+         * @brief The rightmost node.
+         * @return const value_type& value of the rightmost node.
+         *          Past the end const_iterator if tree is empty.
+         */
+        const value_type& back() const {
+            if(empty()) end();
+            return *(--end());
+        }
+
+        /**
+         * @return iterator at the position of the leftmost node.
+         *          Past the end iterator if tree is empty.
+         */
+        iterator begin() {
+            if(empty()) return end();
+            return iterator(*this, first);
+        }
+
+        /**
+         * @return const_iterator at the position of the leftmost node.
+         *          Past the end const_iterator if tree is empty.
          */
         const_iterator begin() const {
             if(empty()) return end();
@@ -934,140 +1625,965 @@ namespace DM852 {
             Node* root;
             Node* first;
             Node* last;
-            static Comp comp;
+            [[no_unique_address]] Comp comp; // each tree has its own, so trees on other threads never share it
             int tree_size, max_size;
             float alpha;
+            bool adaptive = false; // tune alpha from the observed lookups and changes
+            static constexpr int adapt_period = 4096; // operations between two changes of alpha
+            mutable std::atomic<long> reads = 0; // lookups since alpha was last tuned, atomic so const lookups can run in parallel
+            long writes = 0; // insertions and erases since alpha was last tuned
+            int h_cache = 0; // h_alpha() for sizes in [h_min, h_max)
+            double h_min = 0, h_max = 0;
+            bool incremental = false; // split big rebuilds over later operations
+            bool pending_root = false; // the whole tree is waiting to be rebuilt
+            std::deque<Key> pending; // keys of the roots of subtrees waiting to be rebuilt
+            int threads = 1; // threads used by the bulk operations, 0 for one per core
+            Pool<Node> pool; // all nodes of the tree are created in here
+            std::vector<Node*> path; // ancestors found by the last locate(), reused to avoid allocations
+            [[no_unique_address]] mutable Stats stats; // takes no space with NoStats
+
+            /**
+             * @brief Creates a node in the pool, and counts it in the statistics.
+             * @param args arguments for the constructer of the node.
+             * @return Node* the new node.
+             */
+            template<typename... Args>
+            Node* create_node(Args&&... args) {
+                if constexpr(Stats::enabled)
+                    stats.allocated(1);
+                return pool.create(std::forward<Args>(args)...);
+            }
+
+            /**
+             * @brief Counts a descent from the root in the statistics.
+             * @param depth number of nodes visited.
+             * @param comparisons number of key comparisons made.
+             */
+            void note_search([[maybe_unused]] int depth, [[maybe_unused]] int comparisons) const {
+                if constexpr(Stats::enabled)
+                    stats.search(depth, comparisons);
+            }
+
+            /**
+             * @brief Destroys every node of the tree, and gives their memory back to the pool.
+             *          Does not reset root or the sizes.
+             *
+             *          Runtime: O(n), O(1) if value_type is trivially destructible.
+             */
+            void free_nodes() {
+                if constexpr(!std::is_trivially_destructible_v<value_type>) {
+                    Node* n = first;
+                    while(n) { // the nodes are already in a list, so no walk through the tree is needed
+                        Node* next = n->succ;
+                        std::destroy_at(n);
+                        n = next;
+                    }
+                }
+                pool.reset();
+            }
+
+            // operator<=> can replace Comp: 1 if Comp is std::less, -1 if it is std::greater, 0 if not.
+            static constexpr int three_way = !std::three_way_comparable<Key> ? 0
+                : std::is_same_v<Comp, std::less<Key>> || std::is_same_v<Comp, std::less<>> ? 1
+                : std::is_same_v<Comp, std::greater<Key>> || std::is_same_v<Comp, std::greater<>> ? -1 : 0;
+
+            /**
+             * @brief Compares two keys in the order given by Comp.
+             *          If Comp is std::less or std::greater and Key has operator<=>, a single
+             *          three-way comparison is used, which is cheaper than two calls of comp for keys like strings.
+             *          Otherwise comp is called, twice if a does not go before b.
+             *
+             * @param a first key.
+             * @param b second key.
+             * @return int negative if a goes before b, 0 if they are equal, positive if a goes after b.
+             */
+            int compare(const Key& a, const Key& b) const {
+                if constexpr(three_way != 0) {
+                    auto c = a <=> b;
+                    return three_way * ((c > 0) - (c < 0));
+                } else {
+                    if(comp(a, b)) return -1;
+                    return comp(b, a);
+                }
+            }
+
+            /**
+             * @brief Finds the node with the given key.
+             *          With a three-way comparison the search stops as soon as the key is found.
+             *          Otherwise it only asks comp whether a node goes before the key, remembers the
+             *          last node that does not, and checks that node for equality at the end.
+             *          Both ways use a single comparison per level, and Key needs no operator!=.
+             *          Runtime: O(log n)
+             *
+             * @param key to find.
+             * @return Node* with the key, nullptr if not found.
+             */
+            Node* find_node(const Key& key) const {
+                note_reads(1);
+                Node* n = root;
+                int depth = 0;
+                if constexpr(three_way != 0) {
+                    while(n) {
+                        depth++;
+                        int c = compare(key, n->pair.first);
+                        if(c == 0) {
+                            note_search(depth, depth);
+                            return n;
+                        }
+                        n = c < 0 ? n->left : n->right;
+                    }
+                    note_search(depth, depth);
+                    return nullptr;
+                } else {
+                    Node* candidate = nullptr;
+                    while(n) {
+                        depth++;
+                        bool before = comp(n->pair.first, key);
+                        candidate = before ? candidate : n;
+                        n = before ? n->right : n->left;
+                    }
+                    note_search(depth, depth + (candidate != nullptr));
+                    if(candidate && !comp(key, candidate->pair.first))
+                        return candidate;
+                    return nullptr;
+                }
+            }
+
+            /**
+             * @brief Finds the first node whose key is not smaller than key (or bigger if upper).
+             *          Remembers the last node where the descent went left, one comparison per level.
+             *          Runtime: O(log n)
+             *
+             * @param key to search for.
+             * @param upper if true find the first key bigger than key.
+             * @return Node* the found node, nullptr if there is none.
+             */
+            Node* bound_node(const Key& key, bool upper) const {
+                note_reads(1);
+                Node* candidate = nullptr;
+                Node* n = root;
+                int depth = 0;
+                while(n) {
+                    depth++;
+                    bool right = upper ? !comp(key, n->pair.first) : comp(n->pair.first, key);
+                    candidate = right ? candidate : n;
+                    n = right ? n->right : n->left;
+                }
+                note_search(depth, depth);
+                return candidate;
+            }
+
+            /**
+             * @brief Finds the k-th smallest node by descending on the subtree sizes.
+             *          Runtime: O(log n)
+             *
+             * @param k position of the node in sorted order.
+             * @return Node* the k-th node, nullptr if k is not in [0, size()).
+             */
+            Node* select_node(int k) const {
+                if(k < 0 || k >= tree_size)
+                    return nullptr;
+                Node* n = root;
+                while(n) {
+                    int l = node_size(n->left);
+                    if(k < l)
+                        n = n->left;
+                    else if(k == l)
+                        return n;
+                    else {
+                        k -= l + 1;
+                        n = n->right;
+                    }
+                }
+                return nullptr;
+            }
 
             /**
              * @brief calculates floor(log_{1/alpha}(n)), n = size of the tree.
+             *          The result is cached together with the range of sizes it is valid for,
+             *          which is [(1/alpha)^h, (1/alpha)^(h+1)), so it is only calculated again
+             *          when the size leaves the range, and insert() does not call log().
+             *          Runtime: O(1) - amortized.
              * @return int
              */
             int h_alpha() {
-                // this is equal to log(tree_size) with base 1/alpha:
-                return floor(log(tree_size) / log(1/alpha));
+                if(tree_size < h_min || tree_size >= h_max) {
+                    // the largest h with (1/alpha)^h <= tree_size, which is log(tree_size) with base 1/alpha:
+                    double base = 1 / alpha;
+                    h_cache = 0;
+                    h_min = 1;
+                    while(h_min * base <= tree_size) {
+                        h_min *= base;
+                        h_cache++;
+                    }
+                    h_max = h_min * base;
+                    if(tree_size == 0)
+                        h_min = 0;
+                }
+                return h_cache;
             }
 
             /**
-             * @brief Recursive function to calculate the size of a node
-             *          by calculating the size of its subtrees.
+             * @brief Empties the cache of h_alpha(), so it is calculated again. Used when alpha changes.
+             */
+            void reset_h_alpha() {
+                h_min = h_max = 0;
+            }
+
+            /**
+             * @brief Counts lookups for the adaptive mode.
+             * @param k number of lookups.
+             */
+            void note_reads(long k) const {
+                if(adaptive)
+                    reads.fetch_add(k, std::memory_order_relaxed);
+            }
+
+            /**
+             * @brief Counts an insertion or erase for the adaptive mode,
+             *          and tunes alpha if adapt_period operations have been counted.
+             *          Runtime: O(1)
+             */
+            void note_write() {
+                if(!adaptive)
+                    return;
+                long r = reads.load(std::memory_order_relaxed);
+                if(++writes + r < adapt_period)
+                    return;
+                float read_fraction = float(r) / (r + writes);
+                set_alpha(loose_alpha - read_fraction * (loose_alpha - tight_alpha));
+                reads.store(0, std::memory_order_relaxed);
+                writes = 0;
+            }
+
+            /**
+             * @brief Returns the size of the subtree rooted at a node.
+             *          The sizes are cached in the nodes and kept up to date by
+             *          insert(), erase() and build().
              *
-             *          Runtime: O(n)
+             *          Runtime: O(1)
              * @param node to find the size on.
-             * @return int size of node.
+             * @return int size of node, 0 if node is nullptr.
              */
-            int node_size(Node* node) {
-                if(node == nullptr) return 0;
-                return (node_size(node->left) + node_size(node->right)) + 1;
+            int node_size(const Node* node) const {
+                return node ? node->size : 0;
             }
 
             /**
-             * @brief Builds a n-sized tree given linked list of nodes
-             *        Uses divide and conquer approach to build the tree.
+             * @brief Climbs a search path to the lowest node whose subtree can contain the key.
+             *          Used to start a search from the previous position when keys come in sorted order.
+             *          Pre-condition: key is bigger than the key the path was found for.
+             *
+             * @param trail nodes from the root down to where the previous search ended. Nodes are popped off the end.
+             * @param key to search for later.
+             */
+            void climb(std::vector<Node*>& trail, const Key& key) const {
+                while(trail.size() > 1) {
+                    Node* n = trail.back();
+                    Node* parent = trail[trail.size() - 2];
+                    if(n == parent->left && comp(key, parent->pair.first))
+                        break; // key is between the smallest key of the subtree and the parent
+                    trail.pop_back();
+                }
+            }
+
+            /**
+             * @brief Searches a batch of keys in sorted order. Used by find_batch().
+             * @param from iterator to the first key.
+             * @param to past the end iterator of the keys.
+             * @return std::vector<Node*> the found node for every key, in the order of the keys.
+             */
+            template<typename InputIt>
+            std::vector<Node*> find_batch_nodes(InputIt from, InputIt to) const {
+                std::vector<Key> keys(from, to);
+                note_reads(keys.size());
+                std::vector<int> order(keys.size());
+                std::iota(order.begin(), order.end(), 0);
+                std::sort(order.begin(), order.end(), [this, &keys](int a, int b) {
+                    return comp(keys[a], keys[b]);
+                });
+                std::vector<Node*> res(keys.size(), nullptr);
+                std::vector<Node*> trail; // path of the previous search
+                for(size_t i = 0; i < order.size(); i++) {
+                    const Key& key = keys[order[i]];
+                    if(i > 0 && !comp(keys[order[i-1]], key)) { // same key as the previous one
+                        res[order[i]] = res[order[i-1]];
+                        continue;
+                    }
+                    Node* n = root;
+                    if(!trail.empty()) {
+                        climb(trail, key);
+                        n = trail.back();
+                        trail.pop_back();
+                    }
+                    while(n) {
+                        trail.push_back(n);
+                        int c = compare(key, n->pair.first);
+                        if(c == 0)
+                            break;
+                        n = c < 0 ? n->left : n->right;
+                    }
+                    res[order[i]] = n;
+                }
+                return res;
+            }
+
+            /**
+             * @brief Merges a sorted batch without equal keys into the tree, and builds the whole tree again.
+             *          Used by insert_batch() when the batch is big compared to the tree.
+             *          Runtime: O(n + k)
+             *
+             * @param batch sorted key value pairs. The pairs are moved into the tree.
+             * @return int number of keys that were not in the tree before.
+             */
+            int merge_batch(std::vector<std::pair<Key, Value>>& batch) {
+                Node* cur = first;
+                first = nullptr;
+                Node* tail = nullptr;
+                int n = 0;
+                int inserted = 0;
+                size_t i = 0;
+                while(cur || i < batch.size()) {
+                    Node* take;
+                    if(i == batch.size() || (cur && comp(cur->pair.first, batch[i].first))) {
+                        take = cur;
+                        cur = cur->succ;
+                    } else if(cur && !comp(batch[i].first, cur->pair.first)) { // key already exists
+                        cur->pair.second = std::move(batch[i].second);
+                        take = cur;
+                        cur = cur->succ;
+                        i++;
+                    } else {
+                        take = create_node(std::move(batch[i].first), std::move(batch[i].second));
+                        i++;
+                        inserted++;
+                    }
+                    append(take, tail);
+                    n++;
+                }
+                build_list(n, tail);
+                return inserted;
+            }
+
+            /**
+             * @brief Builds the whole tree again from the sorted list of nodes that starts at first.
+             *          Used after the list was merged with another list, or loaded.
+             *          A big list is built in parallel with build_parallel() if set_threads() allows it.
              *          Runtime: O(n)
-             *          Described in "chapter 19 scapegoat trees" by Igal Galperin and Ronald L. Rivest.
-             *          https://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.309.9376
              *
-             * @param n size of tree to build
-             * @param x first element of the list
-             * @return Node* pointer to a noe whose left child is the root of the built tree.
+             * @param n number of nodes in the list.
+             * @param tail last node of the list, nullptr if the list is empty.
+             */
+            void build_list(int n, Node* tail) {
+                last = tail;
+                if constexpr(Stats::enabled) {
+                    auto start = std::chrono::steady_clock::now();
+                    root = build_all(n);
+                    stats.build_time(std::chrono::steady_clock::now() - start);
+                    stats.bulk_build();
+                } else {
+                    root = build_all(n);
+                }
+                tree_size = max_size = n;
+                pending_root = false; // the whole tree is balanced now
+                pending.clear();
+            }
+
+            /**
+             * @brief Builds a perfectly balanced tree of the whole sorted list, on one thread or several, see build_list().
+             *          Runtime: O(n)
+             *
+             * @param n number of nodes in the list.
+             * @return Node* root of the built tree.
+             */
+            Node* build_all(int n) {
+                int t = get_threads();
+                if(t > 1 && n >= parallel_cutoff) {
+                    std::vector<Node*> samples; // every sample_stride-th node, so the threads can find their part of the list
+                    int i = 0;
+                    for(Node* x = first; x; x = x->succ, i++)
+                        if(i % sample_stride == 0)
+                            samples.push_back(x);
+                    return build_parallel(samples, 0, n, t);
+                }
+                Node* list = first;
+                return build(n, list);
+            }
+
+            /**
+             * @brief Where a key is in the tree, or where a node with the key should be linked in.
+             *          The ancestors are in path.
+             */
+            struct Position {
+                Node* node = nullptr; // node with the key, nullptr if not found
+                int c = 0;            // the new node is the left child of path.back() if c < 0, else the right
+            };
+
+            /**
+             * @brief Searches for a key, with one comparison per level, and remembers
+             *          everything needed to link a new node in if it is not found.
+             *          The visited nodes are kept in path, from the root down to the node with the key,
+             *          or down to the parent of the new node if the key is not found.
+             *          Runtime: O(log n)
+             *
+             * @param key to search for.
+             * @return Position of the key.
+             */
+            Position locate(const Key& key) {
+                Position pos;
+                path.clear();
+                Node* n = root;
+                while(n) {
+                    path.push_back(n);
+                    pos.c = compare(key, n->pair.first);
+                    if (pos.c < 0)
+                        n = n->left;
+                    else if (pos.c == 0) {
+                        pos.node = n;
+                        break;
+                    }
+                    else
+                        n = n->right;
+                }
+                note_search(path.size(), path.size());
+                return pos;
+            }
+
+            /**
+             * @brief Links a new node in below path.back(), and into the sorted list of nodes.
+             *          The neighbours in the list are the parent and the old neighbour of the parent,
+             *          so no search is needed. Does not rebalance.
+             *          Runtime: O(depth)
+             *
+             * @param node the new node.
+             * @param c the node is linked in as the left child if c < 0, else as the right child.
+             * @return Node* the new node.
              */
-            Node* build(float n, Node* x) {
-                if (n == 0.0) {
-                    x->left = nullptr;
-                    return x;
+            Node* attach(Node* node, int c) {
+                Node* parent = path.empty() ? nullptr : path.back();
+                if(!parent) {
+                    root = first = last = node;
+                } else if(c < 0) {
+                    parent->left = node;
+                    node->succ = parent;
+                    node->pred = parent->pred;
+                } else {
+                    parent->right = node;
+                    node->pred = parent;
+                    node->succ = parent->succ;
                 }
-                Node* r = build(ceil((n-1)/2), x);
-                Node* s = build(floor((n-1)/2), r->right);
-                r->right = s->left;
-                // Update parent pointers:
-                if(r->right != nullptr)
-                    r->right->parent = r;
-                if(r->left != nullptr)
-                    r->left->parent = r;
-                s->left = r;
-                return s;
+                if(parent) {
+                    if(node->pred)
+                        node->pred->succ = node;
+                    else
+                        first = node;
+                    if(node->succ)
+                        node->succ->pred = node;
+                    else
+                        last = node;
+                }
+                for(Node* p : path) // the new node is now part of every subtree on the path
+                    p->size++;
+                tree_size++;
+                max_size = std::max(max_size, tree_size);
+                return node;
+            }
+
+            /**
+             * @brief Links a new node in at a position found by locate(), and rebalances the tree.
+             *          Pre-condition: the tree has not changed since locate() was called.
+             *          Runtime: O_A(log n) - amortized.
+             *
+             * @param node the new node.
+             * @param pos position of the key of the node.
+             * @return Node* the new node.
+             */
+            Node* link(Node* node, const Position& pos) {
+                attach(node, pos.c);
+                /* Self balancing part: */
+                rebalance();
+                note_write();
+                if(rebuilding())
+                    rebuild_work(rebuild_budget);
+                return node;
             }
 
             /**
-             * @brief Recursively flattens a binary tree and appends the linked list of nodes y
-             *        Returns the result as a linked list of nodes.
+             * @brief Appends a node to the sorted list of nodes. Used when building a tree from sorted nodes.
+             *
+             * @param node to append.
+             * @param tail last node of the list, nullptr if the list is empty. Is set to node.
+             */
+            void append(Node* node, Node*& tail) {
+                append(node, first, tail);
+            }
+
+            /**
+             * @brief Overloaded append(), for a list which does not start at first.
+             * @param node to append.
+             * @param head first node of the list. Is set to node if the list is empty.
+             * @param tail last node of the list, nullptr if the list is empty. Is set to node.
+             */
+            static void append(Node* node, Node*& head, Node*& tail) {
+                node->pred = tail;
+                node->succ = nullptr;
+                if(tail)
+                    tail->succ = node;
+                else
+                    head = node;
+                tail = node;
+            }
+
+            /**
+             * @brief Removes the node found by locate(), which is the last node on the path.
+             *          Pre-condition: the tree has not changed since locate() was called.
+             *          Runtime: O_A(log n) - amortized
+             */
+            void erase_located() {
+                Node* node = path.back();
+                size_t i = path.size() - 1; // position of node on the path
+                Node* parent = i > 0 ? path[i-1] : nullptr;
+                // take the node out of the list
+                if(node->pred)
+                    node->pred->succ = node->succ;
+                else
+                    first = node->succ;
+                if(node->succ)
+                    node->succ->pred = node->pred;
+                else
+                    last = node->pred;
+
+                if(node->left == nullptr) {
+                    replace_child(parent, node, node->right);
+                } else if (node->right == nullptr){
+                    replace_child(parent, node, node->left);
+                } else {
+                    Node* y = node->succ; // leftmost node in the right subtree, it has no left child
+                    for(Node* n = node->right; n != y; n = n->left)
+                        path.push_back(n);
+                    if(y != node->right) {
+                        path.back()->left = y->right;
+                        y->right = node->right;
+                    }
+                    y->left = node->left;
+                    replace_child(parent, node, y);
+                    path[i] = y;
+                    path.push_back(y);
+                }
+                path.pop_back(); // the removed node, or y at its old position
+                for(size_t j = path.size(); j-- > 0;) // update the cached sizes on the path to the root
+                    path[j]->size = node_size(path[j]->left) + node_size(path[j]->right) + 1;
+                tree_size--;
+                pool.destroy(node);
+                note_write();
+
+                //rebuild tree at root if too unbalanced.
+                if(tree_size < alpha * max_size) {
+                    if(incremental && tree_size > rebuild_budget) {
+                        pending_root = true;
+                    } else {
+                        Node* list = first;
+                        root = rebuild(tree_size, list, true);
+                    }
+                    max_size = tree_size;
+                }
+                if(rebuilding())
+                    rebuild_work(rebuild_budget);
+            }
+
+            /**
+             * @brief Replaces a child of a node with another subtree.
+             *         Described as transplant in: Introduction to Algorithms from Cormen et al. chapter 12 p.296
+             *
+             * @param parent of the old child, nullptr if the old child is the root.
+             * @param u old child.
+             * @param v root of subtree to replace with.
+             */
+            void replace_child(Node* parent, Node* u, Node* v) {
+                if(parent == nullptr)
+                    root = v;
+                else if (u == parent->left)
+                    parent->left = v;
+                else
+                    parent->right = v;
+            }
+
+            /**
+             * @brief Self balancing part of insert.
+             *          Checks if an inserted node is too deep, and if so finds the scapegoat node
+             *          among its ancestors in path using the cached sizes, and rebuilds the tree at that node.
+             *          The nodes of a subtree are next to each other in the sorted list,
+             *          so the rebuild does not need to flatten the subtree first.
+             *          Runtime: O(depth) + O(size of the scapegoat) for the rebuild.
+             *
+             *          Pre-condition: path holds the ancestors of the inserted node.
+             */
+            void rebalance() {
+                //Check if inserted node is too deep:
+                int depth = path.size();
+                if(depth > h_alpha() && tree_size > 2) {
+                    //Find scapegoat node:
+                    for(int i = depth - 1; i >= 0; i--) {
+                        Node* scn = path[i];
+                        int n_size = node_size(scn);
+                        // Check if node is scapegoat candidate:
+                        if(!(node_size(scn->left) <= alpha * n_size && node_size(scn->right) <= alpha * n_size)) {
+                            if(incremental && n_size > rebuild_budget) { // leave it to rebuild_work()
+                                if(i == 0)
+                                    pending_root = true;
+                                else if(pending.empty() || compare(pending.front(), scn->pair.first) != 0)
+                                    pending.push_front(scn->pair.first); // before the other work, it is on a deep path
+                                return;
+                            }
+                            Node* list = scn;
+                            while(list->left) // smallest node of the subtree
+                                list = list->left;
+                            Node* scn_parent = i > 0 ? path[i-1] : nullptr; // nullptr if root is scapegoat node
+                            replace_child(scn_parent, scn, rebuild(n_size, list, false));
+                            max_size = tree_size;
+                            return;
+                        }
+                    }
+                }
+            }
+
+            /**
+             * @brief Does pending rebuild work, see set_incremental().
+             *          The work is a queue of subtrees, named by the key of their root. A subtree of
+             *          up to rebuild_budget nodes is built at once. A bigger one gets its median rotated up
+             *          to its root, and its two children are put at the end of the queue, so the top of
+             *          the tree is balanced first. A key which is no longer in the tree is skipped, and a
+             *          key whose node has moved just gives a different subtree to balance. Either way the
+             *          tree stays a valid search tree.
+             *          Runtime: O(budget + depth), a step which has started is finished even if it uses up the budget
+             *
+             * @param budget number of nodes to visit before returning.
+             */
+            void rebuild_work(long budget) {
+                while(budget > 0 && rebuilding()) {
+                    Node* t;
+                    if(pending_root) {
+                        pending_root = false;
+                        path.clear();
+                        if(root)
+                            path.push_back(root);
+                        t = root;
+                    } else {
+                        Key key = std::move(pending.front());
+                        pending.pop_front();
+                        t = locate(key).node;
+                    }
+                    if(!t)
+                        continue;
+                    budget -= path.size();
+                    Node* parent = path.size() > 1 ? path[path.size() - 2] : nullptr;
+                    int n = t->size;
+                    if(n <= rebuild_budget) {
+                        Node* list = t;
+                        while(list->left) // smallest node of the subtree
+                            list = list->left;
+                        replace_child(parent, t, rebuild(n, list, false));
+                        budget -= n;
+                        continue;
+                    }
+                    int k = n - 1 - (n-1)/2; // rank of the median, the same node as build() would use
+                    path.clear();
+                    Node* m = t;
+                    while(true) {
+                        path.push_back(m);
+                        int l = node_size(m->left);
+                        if(k < l)
+                            m = m->left;
+                        else if(k == l)
+                            break;
+                        else {
+                            k -= l + 1;
+                            m = m->right;
+                        }
+                    }
+                    for(size_t i = path.size() - 1; i > 0; i--)
+                        rotate_up(m, path[i-1], i >= 2 ? path[i-2] : parent);
+                    budget -= 2 * path.size();
+                    pending.push_back(m->left->pair.first); // both halves have at least rebuild_budget/2 nodes
+                    pending.push_back(m->right->pair.first);
+                }
+            }
+
+            /**
+             * @brief Rotates a node up over its parent. The sorted list does not change.
+             *          Runtime: O(1)
+             *
+             * @param x node to rotate up.
+             * @param p parent of x.
+             * @param gp parent of p, nullptr if p is the root.
+             */
+            void rotate_up(Node* x, Node* p, Node* gp) {
+                if(p->left == x) {
+                    p->left = x->right;
+                    x->right = p;
+                } else {
+                    p->right = x->left;
+                    x->left = p;
+                }
+                replace_child(gp, p, x);
+                p->size = node_size(p->left) + node_size(p->right) + 1;
+                x->size = node_size(x->left) + node_size(x->right) + 1;
+            }
+
+            /**
+             * @brief Builds a n-sized tree given linked list of nodes
+             *        Uses divide and conquer approach to build the tree.
+             *        The recursion depth is only log2(n), since the built tree is perfectly balanced.
+             *        The tree has the same shape as in the paper, but the nodes are taken from the front of
+             *        the sorted list, so the tree does not have to be flattened first and no dummy node is needed.
+             *        Only the child pointers and sizes change, the list stays as it is.
              *          Runtime: O(n)
              *          Described in "chapter 19 scapegoat trees" by Igal Galperin and Ronald L. Rivest.
              *          https://citeseerx.ist.psu.edu/viewdoc/summary?doi=10.1.1.309.9376
              *
-             * @param x Root of a tree.
-             * @param y First element of a linked list of nodes.
-             * @return Node* to the first element of the linked list.
+             * @param n size of tree to build
+             * @param list first node in the sorted list. Is moved past the used nodes.
+             * @return Node* root of the built tree.
              */
-            Node* flatten(Node* x, Node* y) {
-                if(x == nullptr)
-                    return y;
-                x->right = flatten(x->right, y);
-                return flatten(x->left, x);
+            Node* build(int n, Node*& list) {
+                if (n == 0)
+                    return nullptr;
+                Node* l = build(n - 1 - (n-1)/2, list); // ceil((n-1)/2), in integers so large sizes stay exact
+                Node* r = list;
+                list = list->succ;
+                r->left = l;
+                r->right = build((n-1)/2, list);
+                r->size = n;
+                return r;
             }
 
             /**
-             * @brief Wrapper for the flatten() method. Calls flatten and removes the parent and left pointers
-             *          This results in a simple linked list where the right pointers act as next pointers.
+             * @brief build() of a subtree which was too unbalanced, counted and timed in the statistics.
              *          Runtime: O(n)
              *
-             * @param x Root of a tree.
-             * @param y First element of a linked list of nodes.
-             * @return Node* to the first element of the linked list.
-             */
-            Node* flatten_wrapper(Node* x, Node* y) {
-                Node* n = flatten(x, y);
-                Node* tmp = n;
-                while(tmp) { // Removes all left and parent pointers when flattening the tree.
-                    tmp->left = nullptr;
-                    tmp->parent = nullptr;
-                    tmp = tmp->right;
+             * @param n size of the subtree.
+             * @param list first node of the subtree in the sorted list. Is moved past the used nodes.
+             * @param full true if it is the whole tree, rebuilt because erases made it too small for max_size.
+             * @return Node* root of the built subtree.
+             */
+            Node* rebuild(int n, Node*& list, [[maybe_unused]] bool full) {
+                if constexpr(Stats::enabled) {
+                    auto start = std::chrono::steady_clock::now();
+                    Node* r = build(n, list);
+                    stats.build_time(std::chrono::steady_clock::now() - start);
+                    stats.rebuild(n, full);
+                    return r;
+                } else {
+                    return build(n, list);
                 }
+            }
+
+            static constexpr int sample_stride = 64; // distance between the samples of build_parallel()
+
+            /**
+             * @brief Finds the node at a position of the list, by walking from the sample before it.
+             * @param samples every sample_stride-th node of the list.
+             * @param i position in the list.
+             * @return Node* at position i.
+             */
+            static Node* node_at(const std::vector<Node*>& samples, int i) {
+                Node* n = samples[i / sample_stride];
+                for(int k = i % sample_stride; k > 0; k--)
+                    n = n->succ;
                 return n;
             }
 
             /**
-             * @brief Replaces the subtrees of one node with the subtree of the other.
-             *         Described in: Introduction to Algorithms from Cormen et al. chapter 12 p.296
+             * @brief Runs two functions at the same time, the first in a new thread, and waits for both.
+             *          An exception in either is passed on to the caller, after both are done.
+             * @param f function which runs in a new thread.
+             * @param g function which runs in the calling thread.
+             */
+            template<typename F, typename G>
+            static void fork_join(F&& f, G&& g) {
+                std::exception_ptr error;
+                std::thread thread([&f, &error] {
+                    try {
+                        f();
+                    } catch(...) {
+                        error = std::current_exception();
+                    }
+                });
+                try {
+                    g();
+                } catch(...) {
+                    thread.join();
+                    throw;
+                }
+                thread.join();
+                if(error)
+                    std::rethrow_exception(error);
+            }
+
+            /**
+             * @brief Parallel build(). The two subtrees of a subtree are built by different threads until
+             *          there is one thread per subtree, or the subtrees are smaller than parallel_cutoff.
+             *          The tree has the same shape as with build(), and the list stays as it is.
+             *          Runtime: O(n / threads + log n)
              *
-             * @param u root of subtree to update
-             * @param v root of subtree to replace with
+             * @param samples every sample_stride-th node of the sorted list.
+             * @param from position in the list of the first node of the subtree.
+             * @param n size of the subtree.
+             * @param t number of threads for the subtree.
+             * @return Node* root of the built subtree.
              */
-            void subtree_shift(Node* u, Node* v) {
-                //replace subtree of u with subtree of v
-                if(u->parent == nullptr)
-                    root = v;
-                else if (u == u->parent->left)
-                    u->parent->left = v;
-                else
-                    u->parent->right = v;
-                if(v != nullptr)
-                    v->parent = u->parent;
+            Node* build_parallel(const std::vector<Node*>& samples, int from, int n, int t) {
+                if(n == 0)
+                    return nullptr;
+                if(t < 2 || n < parallel_cutoff) {
+                    Node* list = node_at(samples, from);
+                    return build(n, list);
+                }
+                int l = n - 1 - (n-1)/2;
+                Node* r = node_at(samples, from + l);
+                fork_join([&] { r->left = build_parallel(samples, from, l, t / 2); },
+                          [&] { r->right = build_parallel(samples, from + l + 1, (n-1)/2, t - t / 2); });
+                r->size = n;
+                return r;
+            }
+
+            /**
+             * @brief Calls a function for the nodes at the positions [from, from + n) in sorted order.
+             *          The range is cut in halves which are walked by different threads, down to
+             *          one thread per range or ranges smaller than parallel_cutoff.
+             *          Runtime: O(n / t + t * log n)
+             *
+             * @param from position of the first node.
+             * @param n number of nodes.
+             * @param t number of threads.
+             * @param f function which is called with a Node*.
+             */
+            template<typename F>
+            void parallel_walk(int from, int n, int t, const F& f) const {
+                if(t < 2 || n < parallel_cutoff) {
+                    Node* node = select_node(from);
+                    for(int i = 0; i < n; i++, node = node->succ)
+                        f(node);
+                    return;
+                }
+                int l = n / 2;
+                fork_join([&] { parallel_walk(from, l, t / 2, f); },
+                          [&] { parallel_walk(from + l, n - l, t - t / 2, f); });
             }
 
             /**
-             * @brief Depth first walk through and makes a copy of each node with all their pointers.
+             * @brief Depth first walk through and makes a copy of each node with all their pointers, see copy_nodes().
+             *         A big tree is copied in parallel with copy_parallel() if set_threads() allows it.
+             *         Also sets the first and last pointers.
              *         Should not be used alone. Use copy constructer or '=' operator.
              *         Runtime: O(n)
              *
-             * @param root root of the tree to copy.
+             * @param other_root root of the tree to copy.
              * @return Node* root of the copied tree.
              */
-            Node* copy_helper(Node* root) {
-                //Goes through the original tree depth first and copies each node
-                if(!root) return nullptr;
-                Node* n = new Node(root->pair->first, root->pair->second);
-                if(root->left) {
-                    n->left = copy_helper(root->left);
-                    if(n->left)
-                        n->left->parent = n;
+            Node* copy_helper(const Node* other_root) {
+                if constexpr(Stats::enabled)
+                    stats.allocated(node_size(other_root));
+                int t = get_threads();
+                if(t < 2 || node_size(other_root) < parallel_cutoff)
+                    return copy_nodes(other_root, pool, first, last);
+                std::vector<Pool<Node>> pools(t); // one pool per thread, they are given to this pool afterwards
+                Copy res = copy_parallel(other_root, pools, 0, t);
+                for(auto& p : pools)
+                    pool.splice(p);
+                first = res.first;
+                last = res.last;
+                return res.root;
+            }
+
+            /**
+             * @brief A copied subtree and the ends of its part of the sorted list.
+             */
+            struct Copy {
+                Node* root = nullptr;
+                Node* first = nullptr;
+                Node* last = nullptr;
+            };
+
+            /**
+             * @brief Parallel copy_nodes(). The two subtrees of a subtree are copied by different threads,
+             *          each with its own pool, until there is one thread per subtree, or the subtrees are smaller
+             *          than parallel_cutoff. The lists of the two copies are linked together through the copy of the root.
+             *          Runtime: O(n / threads + log n)
+             *
+             * @param src root of the subtree to copy.
+             * @param pools one pool per thread.
+             * @param p index of the first pool of the subtree.
+             * @param t number of threads for the subtree, they use the pools [p, p + t).
+             * @return Copy of the subtree.
+             */
+            static Copy copy_parallel(const Node* src, std::vector<Pool<Node>>& pools, int p, int t) {
+                Copy res;
+                if(!src)
+                    return res;
+                if(t < 2 || src->size < parallel_cutoff) {
+                    res.root = copy_nodes(src, pools[p], res.first, res.last);
+                    return res;
                 }
-                if(root->right) {
-                    n->right = copy_helper(root->right);
-                    if(n->right)
-                        n->right->parent = n;
+                int h = t / 2;
+                Node* r = pools[p + h].create(src->pair.first, src->pair.second); // the pool of the calling thread
+                r->size = src->size;
+                Copy l, g;
+                fork_join([&] { l = copy_parallel(src->left, pools, p, h); },
+                          [&] { g = copy_parallel(src->right, pools, p + h, t - h); });
+                r->left = l.root;
+                r->right = g.root;
+                r->pred = l.last;
+                if(l.last)
+                    l.last->succ = r;
+                r->succ = g.first;
+                if(g.first)
+                    g.first->pred = r;
+                res.root = r;
+                res.first = l.first ? l.first : r;
+                res.last = g.last ? g.last : r;
+                return res;
+            }
+
+            /**
+             * @brief Copies every node of a subtree into a pool, so the copy has the same shape.
+             *         The walk is inorder with a stack of the nodes whose right subtree is not copied yet,
+             *         so the copies can be linked into the sorted list as they are visited.
+             *          Runtime: O(n)
+             *
+             * @param other_root root of the subtree to copy.
+             * @param into pool of the copies.
+             * @param head is set to the first node of the copied list.
+             * @param tail is set to the last node of the copied list.
+             * @return Node* root of the copied subtree.
+             */
+            static Node* copy_nodes(const Node* other_root, Pool<Node>& into, Node*& head, Node*& tail) {
+                head = tail = nullptr;
+                if(!other_root) return nullptr;
+                Node* res = into.create(other_root->pair.first, other_root->pair.second);
+                std::vector<std::pair<const Node*, Node*>> stack;
+                const Node* src = other_root;
+                Node* dst = res;
+                while(true) {
+                    while(src) { // copy the left spine
+                        dst->size = src->size;
+                        stack.emplace_back(src, dst);
+                        if(src->left)
+                            dst->left = into.create(src->left->pair.first, src->left->pair.second);
+                        src = src->left;
+                        dst = dst->left;
+                    }
+                    if(stack.empty()) break;
+                    auto [s, d] = stack.back();
+                    stack.pop_back();
+                    append(d, head, tail);
+                    if(s->right) {
+                        d->right = into.create(s->right->pair.first, s->right->pair.second);
+                        src = s->right;
+                        dst = d->right;
+                    }
                 }
-                return n;
+                return res;
             }
     };
 };
@@ -0,0 +1,161 @@
+/**
+ * @file TreeStats.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief Statistics policies for Tree, to see where its time goes.
+ * @date 2022-05-16
+ */
+
+#ifndef TREE_STATS_H
+#define TREE_STATS_H
+
+#include <atomic>
+#include <chrono>
+
+namespace DM852 {
+    /**
+     * @brief The default statistics policy of Tree, which records nothing.
+     *          Every recording in Tree is behind if constexpr(Stats::enabled), and the member takes no space,
+     *          so a Tree with NoStats compiles to the same code as without statistics.
+     */
+    struct NoStats {
+        static constexpr bool enabled = false;
+    };
+
+    /**
+     * @brief A statistics policy which counts what a Tree does, for example Tree<int, int, std::less<int>, TreeStats>.
+     *          The counters are atomic, since const lookups can run in parallel, and they are updated with relaxed
+     *          atomics, so reading them while the tree is used gives close but not exact numbers.
+     *          A Tree starts with zeroed statistics, also a copy, and they are read with Tree::statistics().
+     *
+     *          The sorted list of a Tree means a subtree never has to be flattened before it is rebuilt,
+     *          so all rebuild time is build time. In incremental mode a big rebuild is done in steps,
+     *          and only the subtrees which are built directly are counted as rebuilds, see Tree::set_incremental().
+     */
+    struct TreeStats {
+        static constexpr bool enabled = true;
+        static constexpr int max_depth = 64; // deeper searches are counted in the last bucket of the histogram
+
+        /**
+         * @brief A copy of the counters at one point in time.
+         */
+        struct Counters {
+            long comparisons = 0;   // key comparisons made by searches: find, bounds, insert and erase
+            long searches = 0;      // descents from the root
+            long depth[max_depth] = {}; // depth[d] is the number of searches which visited d nodes
+            long rebuilds = 0;      // subtrees rebuilt by a scapegoat, an erase or the incremental mode
+            long rebuilt_nodes = 0; // sum of the sizes of the rebuilt subtrees
+            long full_rebuilds = 0; // rebuilds of the whole tree because erases shrank it below alpha, done at once
+            long bulk_builds = 0;   // builds of the whole tree from a sorted list: assign, merge, split, ...
+            long build_nanoseconds = 0; // time spent in build(), by rebuilds and bulk builds
+            long allocations = 0;   // nodes created
+
+            /**
+             * @return double average number of nodes visited per search.
+             */
+            double mean_depth() const {
+                long sum = 0;
+                for(int d = 0; d < max_depth; d++)
+                    sum += d * depth[d];
+                return searches ? double(sum) / searches : 0;
+            }
+        };
+
+        TreeStats() = default;
+
+        // the statistics belong to one tree, a copy starts from zero and counts the nodes it copies
+        TreeStats(const TreeStats&) {}
+        TreeStats& operator=(const TreeStats&) { return *this; }
+
+        /**
+         * @return Counters the current values of the counters.
+         */
+        Counters get() const {
+            Counters c;
+            c.comparisons = comparisons.load(std::memory_order_relaxed);
+            c.searches = searches.load(std::memory_order_relaxed);
+            for(int d = 0; d < max_depth; d++)
+                c.depth[d] = depth[d].load(std::memory_order_relaxed);
+            c.rebuilds = rebuilds.load(std::memory_order_relaxed);
+            c.rebuilt_nodes = rebuilt_nodes.load(std::memory_order_relaxed);
+            c.full_rebuilds = full_rebuilds.load(std::memory_order_relaxed);
+            c.bulk_builds = bulk_builds.load(std::memory_order_relaxed);
+            c.build_nanoseconds = build_nanoseconds.load(std::memory_order_relaxed);
+            c.allocations = allocations.load(std::memory_order_relaxed);
+            return c;
+        }
+
+        /**
+         * @brief Sets all counters to zero.
+         */
+        void reset() {
+            comparisons.store(0, std::memory_order_relaxed);
+            searches.store(0, std::memory_order_relaxed);
+            for(int d = 0; d < max_depth; d++)
+                depth[d].store(0, std::memory_order_relaxed);
+            rebuilds.store(0, std::memory_order_relaxed);
+            rebuilt_nodes.store(0, std::memory_order_relaxed);
+            full_rebuilds.store(0, std::memory_order_relaxed);
+            bulk_builds.store(0, std::memory_order_relaxed);
+            build_nanoseconds.store(0, std::memory_order_relaxed);
+            allocations.store(0, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records a descent from the root.
+         * @param d number of nodes visited.
+         * @param c number of key comparisons made.
+         */
+        void search(int d, int c) const {
+            searches.fetch_add(1, std::memory_order_relaxed);
+            comparisons.fetch_add(c, std::memory_order_relaxed);
+            depth[d < max_depth ? d : max_depth - 1].fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records a rebuild of a subtree.
+         * @param n size of the subtree.
+         * @param full true if it is the whole tree, after erases.
+         */
+        void rebuild(long n, bool full) {
+            rebuilds.fetch_add(1, std::memory_order_relaxed);
+            rebuilt_nodes.fetch_add(n, std::memory_order_relaxed);
+            if(full)
+                full_rebuilds.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records a build of the whole tree from a sorted list.
+         */
+        void bulk_build() {
+            bulk_builds.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records time spent building.
+         * @param t duration of the build.
+         */
+        void build_time(std::chrono::steady_clock::duration t) {
+            build_nanoseconds.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(t).count(), std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief Records created nodes.
+         * @param n number of nodes.
+         */
+        void allocated(long n) {
+            allocations.fetch_add(n, std::memory_order_relaxed);
+        }
+
+        private:
+            mutable std::atomic<long> comparisons = 0;
+            mutable std::atomic<long> searches = 0;
+            mutable std::atomic<long> depth[max_depth] = {};
+            std::atomic<long> rebuilds = 0;
+            std::atomic<long> rebuilt_nodes = 0;
+            std::atomic<long> full_rebuilds = 0;
+            std::atomic<long> bulk_builds = 0;
+            std::atomic<long> build_nanoseconds = 0;
+            std::atomic<long> allocations = 0;
+    };
+};
+#endif
@@ -0,0 +1,697 @@
+/**
+ * @file UnrolledList.hpp
+ * @author Emil Ovcina (emovc18@student.sdu.dk)
+ * @brief A doubly linked list which stores several elements in each node.
+ *
+ * @date 2022-05-16
+ */
+#ifndef UNROLLED_LIST_H
+#define UNROLLED_LIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "Pool.hpp"
+
+namespace DM852 {
+/**
+ * @brief An unrolled list: a doubly linked list of nodes, where every node holds up to N elements in an array.
+ *          It has the same operations as List, but the pointers are shared by N elements, and
+ *          iterating walks through an array most of the time, so it misses the cache about once per node.
+ *          A full node is split in two when an element is inserted in it, and a node is merged with
+ *          the next one when they both fit in half a node after an erase, so the nodes stay at least a quarter full on average.
+ *
+ *          Iterator stability, which is weaker than for List since the elements of a node are moved:
+ *          push_back() invalidates no iterators, pop_back() only those to the last element.
+ *          insert() and erase() invalidate the iterators to the node they change, and to the
+ *          node that is merged into it, but the iterators to other nodes stay valid.
+ *
+ * @tparam T type of the elements.
+ * @tparam N number of elements per node, by default about four cache lines of elements.
+ */
+template<typename T, int N = std::max<int>(4, 256 / sizeof(T))>
+struct UnrolledList {
+    static_assert(N >= 2, "a node must hold at least two elements, so it can be split");
+    using value_type = T;
+    private:
+        /**
+         * @brief Nested Node class. The elements [0, count) of the array are constructed.
+         */
+        struct Node {
+            Node* prev;
+            Node* next;
+            int count;
+            alignas(T) unsigned char storage[N * sizeof(T)];
+
+            /**
+             * @brief Construct a new empty Node object.
+             */
+            Node() {
+                prev = nullptr;
+                next = nullptr;
+                count = 0;
+            }
+
+            /**
+             * @return T* to the array of elements.
+             */
+            T* data() {
+                return std::launder(reinterpret_cast<T*>(storage));
+            }
+
+            /**
+             * @return const T* to the array of elements.
+             */
+            const T* data() const {
+                return std::launder(reinterpret_cast<const T*>(storage));
+            }
+        };
+    public:
+        struct iterator {
+            friend struct UnrolledList;
+            friend struct const_iterator;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = value_type*;
+            using reference = value_type&;
+
+            /**
+             * @brief Default constructer.
+             */
+            iterator() = default;
+
+            /**
+             * @brief Constructer.
+             * @param list reference to the list which the node belongs to.
+             * @param node pointer to the node where the iterator starts, nullptr for past the end.
+             * @param index position of the element in the node.
+             */
+            iterator(UnrolledList& list, Node* node, int index) : list(&list), node(node), index(index) {}
+
+            /**
+             * @brief dereference operator overloaded.
+             * @return reference to the element.
+             */
+            reference operator*() const {
+                return node->data()[index];
+            }
+
+            /**
+             * @brief Member access operator.
+             * @return pointer to the element.
+             */
+            pointer operator->() const {
+                return node->data() + index;
+            }
+
+            /**
+             * @brief Pre-increment operator. Moves to the next element of the node, or the first element of the next node.
+             * @return iterator ref with the next element.
+             */
+            iterator& operator++() {
+                if(++index == node->count) {
+                    node = node->next;
+                    index = 0;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Post-increment operator, but returns a copy of the iterator before it is moved.
+             * @return iterator.
+             */
+            iterator operator++(int) {
+                auto tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Pre-decrement operator. Moves to the previous element, the past the end iterator moves to the last element.
+             * @return iterator ref with the previous element.
+             */
+            iterator& operator--() {
+                if(node == nullptr) {
+                    node = list->tail;
+                    index = node->count - 1;
+                } else if(index == 0) {
+                    node = node->prev;
+                    index = node->count - 1;
+                } else
+                    index--;
+                return *this;
+            }
+
+            /**
+             * @brief Post-decrement operator, but returns a copy of the iterator before it is moved.
+             * @return iterator.
+             */
+            iterator operator--(int) {
+                auto tmp = *this;
+                --*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Equality operator. Checks if the iterators are at the same element.
+             * @param rhs iterator ref to compare with.
+             * @return true if this is equal to rhs
+             */
+            bool operator==(const iterator& rhs) const {
+                return node == rhs.node && index == rhs.index;
+            }
+
+            /**
+             * @brief Inequality operator.
+             * @param rhs iterator ref to compare with.
+             * @return true if this is not equal to rhs
+             */
+            bool operator!=(const iterator& rhs) const {
+                return !(*this == rhs);
+            }
+
+            private:
+                UnrolledList* list = nullptr;
+                Node* node = nullptr;
+                int index = 0;
+        };
+
+        struct const_iterator {
+            friend struct UnrolledList;
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+            using value_type = T;
+            using pointer = const value_type*;
+            using reference = const value_type&;
+
+            /**
+             * @brief Default constructer.
+             */
+            const_iterator() = default;
+
+            /**
+             * @brief Constructer.
+             * @param list reference to the list which the node belongs to.
+             * @param node pointer to the node where the const_iterator starts, nullptr for past the end.
+             * @param index position of the element in the node.
+             */
+            const_iterator(const UnrolledList& list, Node* node, int index) : list(&list), node(node), index(index) {}
+
+            /**
+             * @brief Copy Construct const_iterator. Used to convert iterator to const_iterator.
+             * @param other iterator reference.
+             */
+            const_iterator(const iterator& other) : list(other.list), node(other.node), index(other.index) {}
+
+            /**
+             * @brief dereference operator overloaded.
+             * @return reference to the element.
+             */
+            reference operator*() const {
+                return node->data()[index];
+            }
+
+            /**
+             * @brief Member access operator.
+             * @return pointer to the element.
+             */
+            pointer operator->() const {
+                return node->data() + index;
+            }
+
+            /**
+             * @brief Pre-increment operator. Moves to the next element of the node, or the first element of the next node.
+             * @return const_iterator ref with the next element.
+             */
+            const_iterator& operator++() {
+                if(++index == node->count) {
+                    node = node->next;
+                    index = 0;
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Post-increment operator, but returns a copy of the const_iterator before it is moved.
+             * @return const_iterator.
+             */
+            const_iterator operator++(int) {
+                auto tmp = *this;
+                ++*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Pre-decrement operator. Moves to the previous element, the past the end const_iterator moves to the last element.
+             * @return const_iterator ref with the previous element.
+             */
+            const_iterator& operator--() {
+                if(node == nullptr) {
+                    node = list->tail;
+                    index = node->count - 1;
+                } else if(index == 0) {
+                    node = node->prev;
+                    index = node->count - 1;
+                } else
+                    index--;
+                return *this;
+            }
+
+            /**
+             * @brief Post-decrement operator, but returns a copy of the const_iterator before it is moved.
+             * @return const_iterator.
+             */
+            const_iterator operator--(int) {
+                auto tmp = *this;
+                --*this;
+                return tmp;
+            }
+
+            /**
+             * @brief Equality operator. Checks if the const_iterators are at the same element.
+             * @param rhs const_iterator ref to compare with.
+             * @return true if this is equal to rhs
+             */
+            bool operator==(const const_iterator& rhs) const {
+                return node == rhs.node && index == rhs.index;
+            }
+
+            /**
+             * @brief Inequality operator.
+             * @param rhs const_iterator ref to compare with.
+             * @return true if this is not equal to rhs
+             */
+            bool operator!=(const const_iterator& rhs) const {
+                return !(*this == rhs);
+            }
+
+            private:
+                const UnrolledList* list = nullptr;
+                Node* node = nullptr;
+                int index = 0;
+        };
+
+        /**
+         * @brief Construct a new UnrolledList object.
+         */
+        UnrolledList() {
+            head = nullptr;
+            tail = nullptr;
+            list_size = 0;
+        }
+
+        /**
+         * @brief Copy Construct a new UnrolledList object.
+         *          The elements are copied into full nodes, so the copy is as compact as possible.
+         *
+         *          Runtime: O(n)
+         * @param other list object.
+         */
+        UnrolledList(const UnrolledList& other) : UnrolledList() {
+            for(const T& elem : other)
+                push_back(elem);
+        }
+
+        /**
+         * @brief Move Constructer. This list takes ownership of other lists nodes.
+         * @param other list object.
+         */
+        UnrolledList(UnrolledList&& other) : pool(std::move(other.pool)) {
+            head = other.head;
+            tail = other.tail;
+            list_size = other.list_size;
+            other.head = other.tail = nullptr;
+            other.list_size = 0;
+        }
+
+        /**
+         * @brief Move Assignment operator.
+         *          This list takes ownership of other lists nodes.
+         * @param other list object.
+         */
+        UnrolledList& operator=(UnrolledList&& other) {
+            if(this == &other) return *this;
+            free_nodes();
+            pool = std::move(other.pool);
+            head = other.head;
+            tail = other.tail;
+            list_size = other.list_size;
+            other.head = other.tail = nullptr;
+            other.list_size = 0;
+            return *this;
+        }
+
+        /**
+         * @brief Desctruct the UnrolledList object.
+         */
+        ~UnrolledList() {
+            free_nodes();
+        }
+
+        /**
+         * @brief Copy Assign - overloading '='
+         *          The elements are copied into full nodes.
+         *
+         *          Runtime: O(n)
+         * @param other list object.
+         * @return copied UnrolledList&
+         */
+        UnrolledList& operator=(const UnrolledList& other) {
+            if(this == &other) return *this;
+            clear(); // the blocks are kept, so the copy does not allocate unless it is bigger
+            for(const T& elem : other)
+                push_back(elem);
+            return *this;
+        }
+
+        /**
+         * @brief Equality comparison - overloading '=='
+         *          The lists must have the same elements in the same order, the nodes may be filled differently.
+         *
+         *          Runtime: O(n)
+         * @param other list to compare with.
+         * @return true if lists are equal.
+         */
+        bool operator==(const UnrolledList& other) const {
+            return size() == other.size() && std::equal(begin(), end(), other.begin());
+        }
+
+        /**
+         * @brief Return size of list
+         * @return int
+         */
+        int size() const {
+            return list_size;
+        }
+
+        /**
+         * @brief Checks the size of the list, and if 0 it is empty.
+         * @return true if list is empty.
+         */
+        bool empty() const {
+            return list_size == 0;
+        }
+
+        /**
+         * @brief Inserts a new element at the end of the list. A new node is only made when the tail node is full.
+         *          Runtime: O(1) - amortized.
+         * @param elem value_type to insert.
+         */
+        void push_back(const value_type& elem) {
+            emplace_back(elem);
+        }
+
+        /**
+         * @brief Inserts a new element at the end of the list, by moving.
+         *          Runtime: O(1) - amortized.
+         * @param elem rvalue value_type to insert by moving.
+         */
+        void push_back(value_type&& elem) {
+            emplace_back(std::move(elem));
+        }
+
+        /**
+         * @brief Inserts an element right before the position given by the const_iterator.
+         *          The later elements of the node are moved one place. If the node is full, it is split
+         *          in two halves first.
+         *          Pre-condition: The const_iterator pos must be an iterator of this list.
+         *
+         *          Runtime: O(N)
+         * @param pos const_iterator at the position to insert.
+         * @param elem value_type to be insterted before pos.
+         * @return iterator at the inserted element.
+         */
+        iterator insert(const_iterator pos, const value_type& elem) {
+            return insert(pos, value_type(elem)); // copy first, in case elem is in the part that is moved
+        }
+
+        /**
+         * @brief Inserts an element, by moving, right before the position given by the const_iterator.
+         *          Pre-condition: The const_iterator pos must be an iterator of this list.
+         *
+         *          Runtime: O(N)
+         * @param pos const_iterator at the position to insert.
+         * @param elem rvalue value_type to be insterted, by moving, before pos.
+         * @return iterator at the inserted element.
+         */
+        iterator insert(const_iterator pos, value_type&& elem) {
+            if(pos.node == nullptr) { // end
+                emplace_back(std::move(elem));
+                return iterator(*this, tail, tail->count - 1);
+            }
+            Node* n = pos.node;
+            int i = pos.index;
+            if(n->count == N) {
+                split(n);
+                if(i > n->count) {
+                    i -= n->count;
+                    n = n->next;
+                }
+            }
+            T* a = n->data();
+            if(i == n->count) {
+                new (a + i) T(std::move(elem));
+            } else { // move the elements after i one place up
+                new (a + n->count) T(std::move(a[n->count - 1]));
+                std::move_backward(a + i, a + n->count - 1, a + n->count);
+                a[i] = std::move(elem);
+            }
+            n->count++;
+            list_size++;
+            return iterator(*this, n, i);
+        }
+
+        /**
+         * @brief Removes all elements. The memory blocks of the nodes are kept, so the list can be refilled without allocating.
+         *
+         *          Runtime: O(n), O(1) if T is trivially destructible.
+         */
+        void clear() {
+            free_nodes();
+            head = nullptr;
+            tail = nullptr;
+            list_size = 0;
+        }
+
+        /**
+         * @brief Removes the last element of the list. The tail node is removed when it gets empty.
+         *          Runtime: O(1)
+         */
+        void pop_back() {
+            if(tail) {
+                std::destroy_at(tail->data() + --tail->count);
+                list_size--;
+                if(tail->count == 0)
+                    unlink(tail);
+            }
+        }
+
+        /**
+         * @brief Removes the element at the given position from the list.
+         *          The later elements of the node are moved one place down. An empty node is removed,
+         *          and a node is merged with the next one if they both fit in half a node.
+         *          Pre-condition: pos must be an iterator at an element of this list.
+         *
+         *          Runtime: O(N)
+         * @param pos const_iterator position of the element to be removed.
+         * @return iterator at the element after the removed one.
+         */
+        iterator erase(const_iterator pos) {
+            Node* n = pos.node;
+            int i = pos.index;
+            T* a = n->data();
+            std::move(a + i + 1, a + n->count, a + i);
+            std::destroy_at(a + --n->count);
+            list_size--;
+            if(n->count == 0) {
+                Node* next = n->next;
+                unlink(n);
+                return iterator(*this, next, 0);
+            }
+            if(n->next && n->count + n->next->count <= N / 2)
+                merge_next(n);
+            if(i == n->count)
+                return iterator(*this, n->next, 0);
+            return iterator(*this, n, i);
+        }
+
+        /**
+         * @brief Returns the first element of the list.
+         * @return const value_type& first element.
+         */
+        const value_type& front() const {
+            return *begin();
+        }
+
+        /**
+         * @brief Returns the first element of the list.
+         * @return value_type& first element.
+         */
+        value_type& front() {
+            return *begin();
+        }
+
+        /**
+         * @brief Returns the last element of the list.
+         * @return const value_type& last element.
+         */
+        const value_type& back() const {
+            return tail->data()[tail->count - 1];
+        }
+
+        /**
+         * @brief Returns the last element of the list.
+         * @return value_type& last element.
+         */
+        value_type& back() {
+            return tail->data()[tail->count - 1];
+        }
+
+        /**
+         * @return iterator at the start of the list,
+         *          if list is empty, return a past the end iterator.
+         */
+        iterator begin() {
+            return iterator(*this, head, 0);
+        }
+
+        /**
+         * @return const_terator at the start of the list,
+         *          if list is empty, return a past the end const_iterator.
+         */
+        const_iterator begin() const {
+            return const_iterator(*this, head, 0);
+        }
+
+        /**
+         * @return past the end iterator.
+         */
+        iterator end() {
+            return iterator(*this, nullptr, 0);
+        }
+
+        /**
+         * @return past the end const_iterator.
+         */
+        const_iterator end() const {
+            return const_iterator(*this, nullptr, 0);
+        }
+
+    /**
+     * @brief private member variables
+     */
+    private:
+        int list_size;
+        Node* head;
+        Node* tail;
+        Pool<Node> pool; // all nodes of the list are created in here
+
+        /**
+         * @brief Constructs an element at the end of the list, in the tail node if it has room.
+         * @param args arguments forwarded to the constructer of T.
+         */
+        template<typename... Args>
+        void emplace_back(Args&&... args) {
+            if(tail == nullptr || tail->count == N)
+                link_after(tail, pool.create());
+            new (tail->data() + tail->count) T(std::forward<Args>(args)...);
+            tail->count++;
+            list_size++;
+        }
+
+        /**
+         * @brief Links a new node into the list.
+         * @param prev node to link after, nullptr to link at the head.
+         * @param node to link in.
+         */
+        void link_after(Node* prev, Node* node) {
+            node->prev = prev;
+            node->next = prev ? prev->next : head;
+            if(node->next)
+                node->next->prev = node;
+            else
+                tail = node;
+            if(prev)
+                prev->next = node;
+            else
+                head = node;
+        }
+
+        /**
+         * @brief Takes an empty node out of the list and destroys it.
+         * @param node to remove.
+         */
+        void unlink(Node* node) {
+            if(node->prev)
+                node->prev->next = node->next;
+            else
+                head = node->next;
+            if(node->next)
+                node->next->prev = node->prev;
+            else
+                tail = node->prev;
+            pool.destroy(node);
+        }
+
+        /**
+         * @brief Moves the upper half of a full node into a new node after it.
+         * @param n node to split.
+         */
+        void split(Node* n) {
+            Node* m = pool.create();
+            int keep = N / 2;
+            T* from = n->data();
+            T* to = m->data();
+            for(int k = keep; k < n->count; k++) {
+                new (to + (k - keep)) T(std::move(from[k]));
+                std::destroy_at(from + k);
+            }
+            m->count = n->count - keep;
+            n->count = keep;
+            link_after(n, m);
+        }
+
+        /**
+         * @brief Moves the elements of the next node to the end of a node, and removes the next node.
+         *          Pre-condition: the elements of both nodes fit in one node.
+         * @param n node to merge into.
+         */
+        void merge_next(Node* n) {
+            Node* m = n->next;
+            T* from = m->data();
+            T* to = n->data();
+            for(int k = 0; k < m->count; k++) {
+                new (to + n->count + k) T(std::move(from[k]));
+                std::destroy_at(from + k);
+            }
+            n->count += m->count;
+            m->count = 0;
+            unlink(m);
+        }
+
+        /**
+         * @brief Destroys every element of the list, and gives the memory of the nodes back to the pool.
+         *          Does not reset head, tail or the size.
+         *
+         *          Runtime: O(n), O(1) if T is trivially destructible.
+         */
+        void free_nodes() {
+            if constexpr(!std::is_trivially_destructible_v<T>) {
+                for(Node* n = head; n;) {
+                    Node* next = n->next;
+                    std::destroy(n->data(), n->data() + n->count);
+                    std::destroy_at(n);
+                    n = next;
+                }
+            }
+            pool.reset();
+        }
+};
+};
+#endif
@@ -0,0 +1,513 @@
+#include "../src/List.hpp"
+#include "../src/Serialize.hpp"
+#include "../src/Tree.hpp"
+#include "../src/UnrolledList.hpp"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <list>
+#include <map>
+#include <random>
+#include <sstream>
+#include <string.h>
+#include <string>
+#include <vector>
+#include <utility>
+
+using namespace DM852;
+using Clock = std::chrono::steady_clock;
+
+void micro(int n);
+template<typename L>
+int replay_list(const char* mode, const char* file, int rounds);
+int replay_tree(const char* file, int rounds);
+
+/**
+ * @brief Benchmarks for Tree and List. Build with "make bench", which compiles with -O3 and without sanitizers.
+ *        "./bench.out micro [n]" runs the workloads below on Tree and List next to std::map and std::list, with n operations.
+ *        "./bench.out DLL|ULL|SGT file [rounds]" replays a file of test/input/ rounds times, without the output,
+ *        and prints the time of every command, so a change of any operation can be measured on the same commands.
+ *        Without arguments it runs "micro 200000".
+ */
+int main(int argc, char **argv) {
+    if(argc == 1 || strcmp(argv[1], "micro") == 0) {
+        micro(argc > 2 ? atoi(argv[2]) : 200000);
+        return 0;
+    }
+    if(argc < 3) {
+        std::cout << "Usage: " << argv[0] << " micro [n] | DLL|ULL|SGT file [rounds]" << std::endl;
+        return 1;
+    }
+    int rounds = argc > 3 ? atoi(argv[3]) : 1000;
+    if(strcmp(argv[1], "DLL") == 0)
+        return replay_list<List<int>>(argv[1], argv[2], rounds);
+    if(strcmp(argv[1], "ULL") == 0)
+        return replay_list<UnrolledList<int, 4>>(argv[1], argv[2], rounds);
+    if(strcmp(argv[1], "SGT") == 0)
+        return replay_tree(argv[2], rounds);
+    std::cout << "Unknown mode " << argv[1] << std::endl;
+    return 1;
+}
+
+long sink = 0; // results of the operations are added here, so they are not optimized away
+
+/**
+ * @brief Latencies of one kind of operation, in nanoseconds.
+ */
+struct Latencies {
+    std::vector<long> ns;
+
+    /**
+     * @param q fraction in [0, 1].
+     * @return long the q quantile. Sorts the latencies.
+     */
+    long quantile(double q) {
+        if(ns.empty())
+            return 0;
+        std::sort(ns.begin(), ns.end());
+        return ns[std::min<size_t>(ns.size() - 1, size_t(q * ns.size()))];
+    }
+
+    long total() const {
+        long t = 0;
+        for(long x : ns)
+            t += x;
+        return t;
+    }
+};
+
+/**
+ * @brief Runs a workload twice on a new container: once without clocks for the throughput,
+ *          and once with a clock read around every operation for the latencies.
+ *          The latencies include the cost of reading the clock, about 20ns.
+ * @param workload name of the workload.
+ * @param container name of the container.
+ * @param ops number of operations.
+ * @param make function which returns the container to start from.
+ * @param op function which does operation i on the container, and returns a number for sink.
+ */
+template<typename Make, typename Op>
+void run(const char* workload, const char* container, int ops, Make make, Op op) {
+    double mops;
+    {
+        auto c = make();
+        auto start = Clock::now();
+        for(int i = 0; i < ops; i++)
+            sink += op(c, i);
+        std::chrono::duration<double> t = Clock::now() - start;
+        mops = ops / t.count() / 1e6;
+    }
+    Latencies lat;
+    lat.ns.resize(ops);
+    {
+        auto c = make();
+        for(int i = 0; i < ops; i++) {
+            auto start = Clock::now();
+            sink += op(c, i);
+            lat.ns[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        }
+    }
+    printf("%-14s %-10s %9d %9.2f %8ld %8ld %8ld\n", workload, container, ops, mops,
+           lat.quantile(0.5), lat.quantile(0.99), lat.quantile(0.999));
+}
+
+// the same operations on Tree and std::map
+template<typename K, typename V, typename C, typename S>
+bool put(Tree<K, V, C, S>& t, int k, int v) { return t.insert(k, v).second; }
+bool put(std::map<int, int>& m, int k, int v) { return m.emplace(k, v).second; }
+template<typename M>
+bool has(const M& m, int k) { return m.find(k) != m.end(); }
+template<typename M>
+long drop(M& m, int k) { auto n = m.size(); m.erase(k); return n - m.size(); }
+
+// the same operations on List and std::list
+int get(List<int>& l, int i) { return l.at(i); }
+int get(std::list<int>& l, int i) { return *std::next(l.begin(), i); }
+void put_at(List<int>& l, int i, int v) { l.insert_at(i, v); }
+void put_at(std::list<int>& l, int i, int v) { l.insert(std::next(l.begin(), i), v); }
+void drop_at(List<int>& l, int i) { l.erase_at(i); }
+void drop_at(std::list<int>& l, int i) { l.erase(std::next(l.begin(), i)); }
+
+/**
+ * @brief The workloads of a map.
+ *          insert-heavy: 90% inserts of random keys, 10% lookups, from empty.
+ *          lookup-heavy: 95% lookups of random keys, 5% erase and insert again, on n keys.
+ *          sequential-key: inserts of increasing keys, from empty.
+ *          random-key: a third each of inserts, lookups and erases of random keys in [0, 2n), on n keys.
+ *          erase-storm: erases of all n keys in random order.
+ * @param name of the container.
+ * @param n number of operations and keys.
+ * @param keys a random order of [0, n).
+ * @param random random numbers in [0, 2n).
+ */
+template<typename M>
+void map_workloads(const char* name, int n, const std::vector<int>& keys, const std::vector<int>& random) {
+    auto empty = [] { return M(); };
+    auto full = [&] {
+        M m;
+        for(int k : keys)
+            put(m, k, k);
+        return m;
+    };
+    run("insert-heavy", name, n, empty, [&](M& m, int i) -> long {
+        return i % 10 == 9 ? has(m, keys[i / 2]) : put(m, keys[i], i);
+    });
+    run("lookup-heavy", name, n, full, [&](M& m, int i) -> long {
+        int k = random[i] % n;
+        if(i % 20 == 0)
+            return drop(m, k) + put(m, k, i);
+        return has(m, k);
+    });
+    run("sequential-key", name, n, empty, [&](M& m, int i) -> long {
+        return put(m, i, i);
+    });
+    run("random-key", name, n, full, [&](M& m, int i) -> long {
+        int k = random[i];
+        switch(i % 3) {
+            case 0: return put(m, k, i);
+            case 1: return has(m, k);
+            default: return drop(m, k);
+        }
+    });
+    run("erase-storm", name, n, full, [&](M& m, int i) -> long {
+        return drop(m, keys[i]);
+    });
+}
+
+/**
+ * @brief The workloads of a list. The positions are the keys of a list.
+ *          insert-heavy: 80% push_back, 20% insert at the front, from empty.
+ *          lookup-heavy: reads at random positions, on m elements.
+ *          sequential-key: push_back, from empty.
+ *          random-key: inserts at random positions, from empty up to m elements.
+ *          erase-storm: erases at random positions, of all m elements.
+ *          The positional workloads use m elements, since std::list walks to a position.
+ * @param name of the container.
+ * @param n number of operations.
+ * @param m number of operations and elements of the positional workloads.
+ * @param random random numbers.
+ */
+template<typename L>
+void list_workloads(const char* name, int n, int m, const std::vector<int>& random) {
+    auto empty = [] {
+        L l;
+        if constexpr(requires { l.set_indexed(true); })
+            l.set_indexed(true);
+        return l;
+    };
+    auto full = [&] {
+        L l = empty();
+        for(int i = 0; i < m; i++)
+            l.push_back(i);
+        return l;
+    };
+    run("insert-heavy", name, n, empty, [&](L& l, int i) -> long {
+        if(i % 5 == 4)
+            l.insert(l.begin(), i);
+        else
+            l.push_back(i);
+        return l.size();
+    });
+    run("lookup-heavy", name, m, full, [&](L& l, int i) -> long {
+        return get(l, random[i] % m);
+    });
+    run("sequential-key", name, n, empty, [&](L& l, int i) -> long {
+        l.push_back(i);
+        return l.size();
+    });
+    run("random-key", name, m, empty, [&](L& l, int i) -> long {
+        put_at(l, random[i] % (l.size() + 1), i);
+        return l.size();
+    });
+    run("erase-storm", name, m, full, [&](L& l, int i) -> long {
+        drop_at(l, random[i] % l.size());
+        return l.size();
+    });
+}
+
+/**
+ * @brief Runs all workloads on Tree, std::map, List and std::list.
+ * @param n number of operations.
+ */
+void micro(int n) {
+    n = std::max(n, 10);
+    int m = std::max(n / 10, 10);
+    std::mt19937 rng(852);
+    std::vector<int> keys(n);
+    for(int i = 0; i < n; i++)
+        keys[i] = i;
+    std::shuffle(keys.begin(), keys.end(), rng);
+    std::vector<int> random(n);
+    for(int& x : random)
+        x = std::uniform_int_distribution<int>(0, 2 * n - 1)(rng);
+
+    printf("%-14s %-10s %9s %9s %8s %8s %8s\n", "workload", "container", "ops", "Mops/s", "p50 ns", "p99 ns", "p999 ns");
+    map_workloads<Tree<int, int>>("Tree", n, keys, random);
+    map_workloads<std::map<int, int>>("std::map", n, keys, random);
+    list_workloads<List<int>>("List", n, m, random);
+    list_workloads<std::list<int>>("std::list", n, m, random);
+    printf("(sink %ld)\n", sink);
+}
+
+/**
+ * @brief A line of an input file, split into words.
+ */
+struct Command {
+    std::string name;
+    std::vector<std::string> args;
+};
+
+/**
+ * @brief Reads the commands of an input file, up to "stop".
+ * @param file path of the file.
+ * @param commands are added to this.
+ * @return true if the file could be read.
+ */
+bool read_commands(const char* file, std::vector<Command>& commands) {
+    std::ifstream in(file);
+    if(!in) {
+        std::cout << "Cannot read " << file << std::endl;
+        return false;
+    }
+    for(std::string line; std::getline(in, line);) {
+        std::istringstream words(line);
+        Command c;
+        if(!(words >> c.name))
+            continue;
+        if(c.name == "stop")
+            break;
+        for(std::string w; words >> w;)
+            c.args.push_back(w);
+        commands.push_back(std::move(c));
+    }
+    return true;
+}
+
+/**
+ * @brief Prints the latencies of every command, and the throughput of the whole replay.
+ * @param lat latencies by command name.
+ * @param skipped number of commands which were not valid in their round and left out.
+ */
+void report(std::map<std::string, Latencies>& lat, long skipped) {
+    printf("%-12s %9s %8s %8s %8s %12s\n", "command", "count", "p50 ns", "p99 ns", "p999 ns", "total us");
+    long count = 0, total = 0;
+    for(auto& [name, l] : lat) {
+        if(l.ns.empty()) // only skipped
+            continue;
+        count += l.ns.size();
+        total += l.total();
+        printf("%-12s %9zu %8ld %8ld %8ld %12ld\n", name.c_str(), l.ns.size(),
+               l.quantile(0.5), l.quantile(0.99), l.quantile(0.999), l.total() / 1000);
+    }
+    printf("%ld commands in %.3f ms, %.2f Mops/s, %ld skipped (sink %ld)\n", count, total / 1e6,
+           total ? count * 1e3 / total : 0, skipped, sink);
+}
+
+/**
+ * @brief Times one command, and adds the latency to its kind.
+ * @param l latencies of the command.
+ * @param f the command, returns a number for sink.
+ */
+template<typename F>
+void timed(Latencies& l, F&& f) {
+    auto start = Clock::now();
+    sink += f();
+    l.ns.push_back(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+/**
+ * @brief Replays the list commands of test/input/ a number of rounds on the same lists.
+ *          The output commands (print, print_tmp) are left out. The list keeps growing between rounds,
+ *          so the later rounds work on longer lists. A command which is not valid for the list
+ *          in its round, like pop on an empty list, is skipped and counted.
+ * @param mode DLL or ULL.
+ * @param file path of the input file.
+ * @param rounds number of times to replay the file.
+ * @return int 0 if the file could be read.
+ */
+template<typename L>
+int replay_list(const char* mode, const char* file, int rounds) {
+    std::vector<Command> commands;
+    if(!read_commands(file, commands))
+        return 1;
+    L list, tmp_list;
+    if constexpr(requires { list.set_indexed(true); })
+        list.set_indexed(true);
+    std::map<std::string, Latencies> lat;
+    long skipped = 0;
+    for(int r = 0; r < rounds; r++) {
+        for(const Command& c : commands) {
+            if(c.name == "print" || c.name == "print_tmp") // output only
+                continue;
+            int key = c.args.size() > 0 ? std::stoi(c.args[0]) : 0;
+            int index = c.args.size() > 1 ? std::stoi(c.args[1]) : 0;
+            int n = list.size();
+            Latencies& l = lat[c.name];
+            const std::string& cmd = c.name;
+            if(cmd == "push") {
+                timed(l, [&] { list.push_back(key); return 0; });
+            } else if(cmd == "pop" && n > 0) {
+                timed(l, [&] { list.pop_back(); return 0; });
+            } else if(cmd == "clear") {
+                timed(l, [&] { list.clear(); return 0; });
+            } else if(cmd == "insert" && index <= n) {
+                timed(l, [&] {
+                    if constexpr(requires { list.insert_at(index, key); }) {
+                        list.insert_at(index, key);
+                    } else {
+                        auto iter = list.begin();
+                        for(int i = 0; i < index; i++) ++iter;
+                        list.insert(iter, key);
+                    }
+                    return 0;
+                });
+            } else if(cmd == "erase" && key < n) {
+                timed(l, [&] {
+                    if constexpr(requires { list.erase_at(key); }) {
+                        list.erase_at(key);
+                    } else {
+                        auto iter = list.begin();
+                        for(int i = 0; i < key; i++) ++iter;
+                        list.erase(iter);
+                    }
+                    return 0;
+                });
+            } else if(cmd == "empty") {
+                timed(l, [&] { return int(list.empty()); });
+            } else if(cmd == "size") {
+                timed(l, [&] { return list.size(); });
+            } else if(cmd == "front" && n > 0) {
+                timed(l, [&] { return list.front(); });
+            } else if(cmd == "back" && n > 0) {
+                timed(l, [&] { return list.back(); });
+            } else if(cmd == "copy") {
+                timed(l, [&] { tmp_list = list; return 0; });
+            } else if(cmd == "move") {
+                timed(l, [&] { tmp_list = std::move(list); return 0; });
+            } else if(cmd == "==") {
+                timed(l, [&] { return int(list == tmp_list); });
+            } else {
+                bool done = false;
+                if constexpr(requires { list.sort(); }) {
+                    done = true;
+                    if(cmd == "splice" && key <= n)
+                        timed(l, [&] { list.splice(list.iterator_at(key), tmp_list); return 0; });
+                    else if(cmd == "splice_elem" && key < n && index <= n)
+                        timed(l, [&] { list.splice(list.iterator_at(index), list, list.iterator_at(key)); return 0; });
+                    else if(cmd == "sort")
+                        timed(l, [&] { list.sort(); return 0; });
+                    else if(cmd == "merge")
+                        timed(l, [&] { list.merge(tmp_list); return 0; });
+                    else
+                        done = false;
+                }
+                if(!done)
+                    skipped++;
+            }
+        }
+    }
+    std::cout << mode << " " << file << ", " << rounds << " rounds, " << list.size() << " elements at the end\n";
+    report(lat, skipped);
+    return 0;
+}
+
+/**
+ * @brief Replays the tree commands of test/input/ a number of rounds on the same trees.
+ *          Every round adds round * span to the keys, where span is one more than the biggest key of the file,
+ *          so each round works on its own keys and the tree keeps growing. The positions of select are not moved.
+ *          The output commands (print, print_tmp) are left out, and lookups of missing keys are not dereferenced.
+ * @param file path of the input file.
+ * @param rounds number of times to replay the file.
+ * @return int 0 if the file could be read.
+ */
+int replay_tree(const char* file, int rounds) {
+    std::vector<Command> commands;
+    if(!read_commands(file, commands))
+        return 1;
+    int span = 1;
+    for(const Command& c : commands)
+        if(c.name != "select")
+            for(const std::string& a : c.args)
+                if(!a.empty() && (isdigit(a[0]) || a[0] == '-'))
+                    span = std::max(span, std::abs(std::stoi(a)) + 1);
+
+    Tree<int, std::string> tree, tmp_tree;
+    std::stringstream saved;
+    std::map<std::string, Latencies> lat;
+    long skipped = 0;
+    for(int r = 0; r < rounds; r++) {
+        long offset = long(r) * span;
+        for(const Command& c : commands) {
+            if(c.name == "print" || c.name == "print_tmp") // output only
+                continue;
+            auto arg = [&](size_t i) { return c.args.size() > i ? int(std::stoi(c.args[i]) + offset) : int(offset); };
+            int key = arg(0);
+            std::string value = c.args.size() > 1 ? c.args[1] : "";
+            Latencies& l = lat[c.name];
+            const std::string& cmd = c.name;
+            if(cmd == "size") {
+                timed(l, [&] { return tree.size(); });
+            } else if(cmd == "empty") {
+                timed(l, [&] { return int(tree.empty()); });
+            } else if(cmd == "insert") {
+                timed(l, [&] { return int(tree.insert(key, value).second); });
+            } else if(cmd == "find") {
+                timed(l, [&] { return int(tree.find(key) != tree.end()); });
+            } else if(cmd == "clear") {
+                timed(l, [&] { tree.clear(); return 0; });
+            } else if(cmd == "erase") {
+                timed(l, [&] { tree.erase(key); return 0; });
+            } else if(cmd == "front" && !tree.empty()) {
+                timed(l, [&] { return tree.front().first; });
+            } else if(cmd == "back" && !tree.empty()) {
+                timed(l, [&] { return tree.back().first; });
+            } else if(cmd == "copy") {
+                timed(l, [&] { tmp_tree = tree; return 0; });
+            } else if(cmd == "move") {
+                timed(l, [&] { tmp_tree = std::move(tree); return 0; });
+            } else if(cmd == "==") {
+                timed(l, [&] { return int(tree == tmp_tree); });
+            } else if(cmd == "load") {
+                std::vector<std::pair<int, std::string>> elems;
+                for(size_t i = 0; i + 1 < c.args.size(); i += 2)
+                    elems.push_back(std::make_pair(arg(i), c.args[i + 1]));
+                timed(l, [&] { tree.assign(elems.begin(), elems.end()); return 0; });
+            } else if(cmd == "save") {
+                timed(l, [&] { saved.str(""); return int(write_binary(saved, tree)); });
+            } else if(cmd == "restore") {
+                timed(l, [&] { saved.seekg(0); return int(read_binary(saved, tmp_tree)); });
+            } else if(cmd == "select") {
+                int k = c.args.empty() ? 0 : std::stoi(c.args[0]);
+                timed(l, [&] { return int(tree.select(k) != tree.end()); });
+            } else if(cmd == "rank") {
+                timed(l, [&] { return tree.rank(key); });
+            } else if(cmd == "count") {
+                int hi = arg(1);
+                timed(l, [&] { return tree.count_range(key, hi); });
+            } else if(cmd == "range") {
+                int hi = arg(1);
+                timed(l, [&] {
+                    int n = 0;
+                    for(const auto& p : tree.range(key, hi))
+                        n += p.first;
+                    return n;
+                });
+            } else if(cmd == "lower_bound") {
+                timed(l, [&] { return int(tree.lower_bound(key) != tree.end()); });
+            } else if(cmd == "upper_bound") {
+                timed(l, [&] { return int(tree.upper_bound(key) != tree.end()); });
+            } else {
+                skipped++;
+            }
+        }
+    }
+    std::cout << "SGT " << file << ", " << rounds << " rounds, " << tree.size() << " pairs at the end\n";
+    report(lat, skipped);
+    return 0;
+}
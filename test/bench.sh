@@ -0,0 +1,2 @@
+make bench
+./bench.out "$@"
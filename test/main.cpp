@@ -1,21 +1,66 @@
+#include "../src/Cache.hpp"
+#include "../src/ConcurrentQueue.hpp"
+#include "../src/FrozenTree.hpp"
+#include "../src/IntrusiveList.hpp"
+#include "../src/IntrusiveTree.hpp"
 #include "../src/List.hpp"
+#include "../src/PersistentTree.hpp"
+#include "../src/Serialize.hpp"
 #include "../src/Tree.hpp"
+#include "../src/TreeStats.hpp"
+#include "../src/UnrolledList.hpp"
 
 #include <stdlib.h>
+#include <atomic>
+#include <climits>
+#include <deque>
 #include <iostream>
+#include <iterator>
+#include <sstream>
 #include <string.h>
 #include <vector>
 #include <utility>
 
 using namespace DM852;
 
-void DDL(List<int>& list);
-void SGT(Tree<int, std::string>& tree);
+template<bool Positional = false, typename L>
+void DDL(L& list);
+template<typename T>
+void SGT(T& tree);
+
+/**
+ * @brief A comparator with state, which sorts ascending or descending, to test that every tree keeps its own comparator.
+ */
+struct Order {
+    bool descending = false;
+    bool operator()(int a, int b) const {
+        return descending ? b < a : a < b;
+    }
+};
+template<typename T>
+void PST(T& tree);
+void CQ();
+void INT();
+template<typename C>
+void CACHE(C& cache);
+void STATS();
+template<typename F, typename K>
+std::string frozen_lookup(const F& frozen, K key);
 std::vector<std::string> tokenize(std::string s, std::string del);
 
 /**
  * @brief If first argument is "DLL" run input on doubly linked list.
+ *        if first argument is "IDX" run input on doubly linked list with the skip list index, by position instead of by iterator.
+ *        if first argument is "ULL" run input on unrolled linked list, with small nodes so they are split and merged often.
  *        if first argument is "SGT" run input on Scapegoat tree.
+ *        if first argument is "REV" run input on Scapegoat tree with a comparator which sorts the keys in descending order.
+ *        if first argument is "PST" run input on persistent Scapegoat tree and its snapshots.
+ *        if first argument is "RPST" run the same input on persistent Scapegoat tree with a descending comparator.
+ *        if first argument is "CQ" run input on concurrent queue, from one thread.
+ *        if first argument is "INT" run input on objects which are in an intrusive list and an intrusive tree at the same time.
+ *        if first argument is "LRU" run input on least recently used cache, "LFU" on least frequently used cache.
+ *        Both caches start with capacity 3, and print every entry they evict.
+ *        if first argument is "STATS" run input on Scapegoat tree with the TreeStats policy, and print its counters.
  */
 int main(int argc, char **argv) {
     if(argc == 1) {
@@ -32,20 +77,77 @@ int main(int argc, char **argv) {
         DDL(list);
     }
 
+    //Doubly linked list commands with the index, same as for the doubly linked list
+    if(strcmp(argv[1], "IDX") == 0) {
+        List<int> list;
+        list.set_indexed(true);
+        DDL<true>(list);
+    }
+
+    //Unrolled linked list commands, same as for the doubly linked list
+    if(strcmp(argv[1], "ULL") == 0) {
+        UnrolledList<int, 4> list;
+        DDL(list);
+    }
+
     //Scapegoat tree commands
     if(strcmp(argv[1], "SGT") == 0) {
         Tree<int, std::string> tree;
         SGT(tree);
     }
+
+    //Scapegoat tree commands, with a comparator that has state
+    if(strcmp(argv[1], "REV") == 0) {
+        Tree<int, std::string, Order> tree(Order{true});
+        SGT(tree);
+    }
+
+    //Persistent tree commands
+    if(strcmp(argv[1], "PST") == 0) {
+        PersistentTree<int, std::string> tree;
+        PST(tree);
+    }
+    if(strcmp(argv[1], "RPST") == 0) {
+        PersistentTree<int, std::string, Order> tree(Order{true});
+        PST(tree);
+    }
+
+    //Concurrent queue commands
+    if(strcmp(argv[1], "CQ") == 0)
+        CQ();
+
+    //Intrusive list and tree commands
+    if(strcmp(argv[1], "INT") == 0)
+        INT();
+
+    //Cache commands
+    auto print_evict = [](const int& key, std::string& value) {
+        std::cout << "Evicted: [" << key << "|" << value << "]\n";
+    };
+    if(strcmp(argv[1], "LRU") == 0) {
+        LruCache<int, std::string> cache(3, print_evict);
+        CACHE(cache);
+    }
+    if(strcmp(argv[1], "LFU") == 0) {
+        LfuCache<int, std::string> cache(3, print_evict);
+        CACHE(cache);
+    }
+
+    //Scapegoat tree statistics commands
+    if(strcmp(argv[1], "STATS") == 0)
+        STATS();
     std::cout << std::endl;
 }
 
 /**
  * @brief carries out operations given the list of commands from cin.
+ * @tparam Positional if true, elements are inserted, erased and found with the positional functions of List
+ *          instead of by walking an iterator.
  * @param list
  */
-void DDL(List<int>& list) {
-    List<int> tmp_list;
+template<bool Positional, typename L>
+void DDL(L& list) {
+    L tmp_list;
 
     for (std::string line; std::getline(std::cin, line);) { // parse each line
         std::vector<std::string> command = tokenize(line, " ");
@@ -70,9 +172,13 @@ void DDL(List<int>& list) {
             std::cout << "Cleared list" << "\n";
         }
         if(cmd == "insert") { // insert
-            auto iter = list.begin();
-            for(int i = 0; i < index; i++) ++iter;
-            list.insert(iter, key);
+            if constexpr(Positional) {
+                list.insert_at(index, key);
+            } else {
+                auto iter = list.begin();
+                for(int i = 0; i < index; i++) ++iter;
+                list.insert(iter, key);
+            }
             std::cout << "Inserted: " << key << " at index " << index << "\n";
         }
         if(cmd == "empty") { // empty
@@ -83,10 +189,15 @@ void DDL(List<int>& list) {
                 std::cout << "List is not empty" << "\n";
         }
         if(cmd == "erase") { // erase
-            auto iter = list.begin();
-            for(int i = 0; i < key; i++) ++iter;
-            std::cout << "Erased element: " << *iter << "\n";
-            list.erase(iter);
+            if constexpr(Positional) {
+                std::cout << "Erased element: " << list.at(key) << "\n";
+                list.erase_at(key);
+            } else {
+                auto iter = list.begin();
+                for(int i = 0; i < key; i++) ++iter;
+                std::cout << "Erased element: " << *iter << "\n";
+                list.erase(iter);
+            }
         }
         if(cmd == "size") { // size
             std::cout << list.size() << "\n";
@@ -117,6 +228,38 @@ void DDL(List<int>& list) {
             tmp_list = std::move(list);
             std::cout << "List moved" << "\n";
         }
+        if constexpr(requires { list.sort(); }) {
+            if(cmd == "splice") { // splice all of tmp_list in before index
+                auto iter = list.begin();
+                if constexpr(Positional)
+                    iter = list.iterator_at(key);
+                else
+                    for(int i = 0; i < key; i++) ++iter;
+                list.splice(iter, tmp_list);
+                std::cout << "Spliced list at index " << key << "\n";
+            }
+            if(cmd == "splice_elem") { // move the element at key to before index
+                auto from = list.begin();
+                auto to = list.begin();
+                if constexpr(Positional) {
+                    from = list.iterator_at(key);
+                    to = list.iterator_at(index);
+                } else {
+                    for(int i = 0; i < key; i++) ++from;
+                    for(int i = 0; i < index; i++) ++to;
+                }
+                list.splice(to, list, from);
+                std::cout << "Moved element at index " << key << " to index " << index << "\n";
+            }
+            if(cmd == "sort") {
+                list.sort();
+                std::cout << "Sorted list" << "\n";
+            }
+            if(cmd == "merge") { // merge the sorted tmp_list into the sorted list
+                list.merge(tmp_list);
+                std::cout << "Merged list" << "\n";
+            }
+        }
         if(cmd == "==") {
             if(list == tmp_list)
                 std::cout << "== returned true" << "\n";
@@ -132,10 +275,13 @@ void DDL(List<int>& list) {
 
 /**
  * @brief carries out operations given the list of commands from cin.
+ *          The temporary tree gets the comparator of tree.
  * @param tree
  */
-void SGT(Tree<int, std::string>& tree) {
-    Tree<int, std::string> tmp_tree;
+template<typename T>
+void SGT(T& tree) {
+    T tmp_tree(tree.key_comp());
+    std::stringstream saved;
     for (std::string line; std::getline(std::cin, line);) { // parse each line
         std::vector<std::string> command = tokenize(line, " ");
         int key = 0;
@@ -202,12 +348,666 @@ void SGT(Tree<int, std::string>& tree) {
             else
                 std::cout << "== returned false" << "\n";
         }
+        else if(cmd == "load") { // load key value key value ... - bulk load from a sorted range
+            std::vector<std::pair<int, std::string>> elems;
+            for(size_t i = 1; i + 1 < command.size(); i += 2)
+                elems.push_back(std::make_pair(std::stoi(command[i]), command[i + 1]));
+            tree.assign(elems.begin(), elems.end());
+            std::cout << "Loaded " << tree.size() << " elements\n";
+        }
+        else if(cmd == "load_tmp") { // load_tmp key value key value ... - bulk load the temporary tree from a sorted range
+            std::vector<std::pair<int, std::string>> elems;
+            for(size_t i = 1; i + 1 < command.size(); i += 2)
+                elems.push_back(std::make_pair(std::stoi(command[i]), command[i + 1]));
+            tmp_tree.assign(elems.begin(), elems.end());
+            std::cout << "Loaded " << tmp_tree.size() << " elements into TMP\n";
+        }
+        else if(cmd == "merge") { // merge - move the nodes of the temporary tree whose keys are new into the tree
+            tree.merge(tmp_tree);
+            std::cout << "Merged, " << tree.size() << " elements, " << tmp_tree.size() << " left in TMP\n";
+        }
+        else if(cmd == "union") { // union 0|1 [1] - add the temporary tree, keeping the first (0) or last (1) values, and take its nodes if 1
+            auto policy = key == 0 ? T::duplicates::keep_first : T::duplicates::keep_last;
+            if(command.size() > 2 && std::stoi(command[2]) == 1)
+                tree.set_union(std::move(tmp_tree), policy);
+            else
+                tree.set_union(tmp_tree, policy);
+            std::cout << "Union, " << tree.size() << " elements, " << tmp_tree.size() << " left in TMP\n";
+        }
+        else if(cmd == "intersection") { // intersection - keep the keys which are also in the temporary tree
+            tree.set_intersection(tmp_tree);
+            std::cout << "Intersection, " << tree.size() << " elements\n";
+        }
+        else if(cmd == "difference") { // difference - remove the keys which are in the temporary tree
+            tree.set_difference(tmp_tree);
+            std::cout << "Difference, " << tree.size() << " elements\n";
+        }
+        else if(cmd == "insert_tmp") { // insert_tmp key value - insert into the temporary tree
+            tmp_tree.insert(key, value);
+            std::cout << "Inserted into TMP: [" << key << "|" << value << "]\n";
+        }
+        else if(cmd == "split") { // split key - move the keys not smaller than key into the temporary tree
+            tmp_tree = tree.split(key);
+            std::cout << "Split at " << key << ", " << tree.size() << " and " << tmp_tree.size() << " elements\n";
+        }
+        else if(cmd == "join") { // join - append the temporary tree to the tree
+            tree = T::join(std::move(tree), std::move(tmp_tree));
+            std::cout << "Joined, " << tree.size() << " elements, " << tmp_tree.size() << " left in TMP\n";
+        }
+        else if(cmd == "threads") { // threads n - set the number of threads of the bulk operations of both trees
+            tree.set_threads(key);
+            tmp_tree.set_threads(key);
+            std::cout << "Threads: " << tree.get_threads() << "\n";
+        }
+        else if(cmd == "parallel_check") { // parallel_check - check in parallel that every value is its key, and count the pairs
+            std::atomic<long> pairs = 0, wrong = 0;
+            tree.parallel_for_each([&](const std::pair<const int, std::string>& p) {
+                pairs++;
+                wrong += p.second != std::to_string(p.first);
+            });
+            std::cout << "Checked " << pairs << " pairs, " << wrong << " wrong\n";
+        }
+        else if(cmd == "fill") { // fill lo hi step - bulk load the keys lo, lo + step, ... below hi, each with its key as value
+            int hi = std::stoi(command[2]);
+            int step = command.size() > 3 ? std::stoi(command[3]) : 1;
+            std::vector<std::pair<int, std::string>> elems;
+            for(int k = key; k < hi; k += step)
+                elems.push_back(std::make_pair(k, std::to_string(k)));
+            tree.assign(elems.begin(), elems.end());
+            std::cout << "Filled " << tree.size() << " elements\n";
+        }
+        else if(cmd == "freeze") { // freeze key key ... - look the keys up in a frozen snapshot of the tree
+            // the int keys use the block layout, and the snapshots with long and float keys and with a
+            // comparator which is not std::less (the Eytzinger layout) must give the same answers
+            struct Less {
+                bool operator()(int a, int b) const { return a < b; }
+            };
+            auto frozen = tree.freeze();
+            std::vector<std::pair<long, std::string>> as_long;
+            std::vector<std::pair<float, std::string>> as_float;
+            for(const auto& p : tree) {
+                as_long.push_back(std::make_pair(long(p.first), p.second));
+                as_float.push_back(std::make_pair(float(p.first), p.second));
+            }
+            FrozenTree<long, std::string> frozen_long(as_long.begin(), as_long.end());
+            FrozenTree<float, std::string> frozen_float(as_float.begin(), as_float.end());
+            FrozenTree<int, std::string, Less> frozen_eytzinger(tree.begin(), tree.end());
+            std::cout << "Frozen " << frozen.size() << " elements\n";
+            for(size_t i = 1; i < command.size(); i++) {
+                int k = std::stoi(command[i]);
+                std::string res = frozen_lookup(frozen, k);
+                std::cout << k << ": " << res << "\n";
+                if(frozen_lookup(frozen_long, long(k)) != res)
+                    std::cout << "long keys differ\n";
+                if(frozen_lookup(frozen_float, float(k)) != res)
+                    std::cout << "float keys differ\n";
+                if(frozen_lookup(frozen_eytzinger, k) != res)
+                    std::cout << "Eytzinger layout differs\n";
+            }
+        }
+        else if(cmd == "insert_range") { // insert_range lo hi - insert the keys in [lo, hi) one by one, each with its key as value
+            int hi = std::stoi(command[2]);
+            int inserted = 0, pending = 0;
+            for(int k = key; k < hi; k++) {
+                inserted += tree.insert(k, std::to_string(k)).second;
+                pending += tree.rebuilding();
+            }
+            std::cout << "Inserted " << inserted << " new keys, size " << tree.size() << "\n";
+            if(tree.is_incremental())
+                std::cout << "Rebuild work was pending after " << pending << " inserts\n";
+        }
+        else if(cmd == "find_range") { // find_range lo hi - find the keys in [lo, hi) one by one
+            int hi = std::stoi(command[2]);
+            int found = 0;
+            for(int k = key; k < hi; k++)
+                found += tree.find(k) != tree.end();
+            std::cout << "Found " << found << " of " << hi - key << " keys\n";
+        }
+        else if(cmd == "erase_range") { // erase_range lo hi - erase the keys in [lo, hi) one by one
+            int hi = std::stoi(command[2]);
+            int pending = 0;
+            for(int k = key; k < hi; k++) {
+                tree.erase(k);
+                pending += tree.rebuilding();
+            }
+            std::cout << "Erased keys in [" << key << ", " << hi << "), size " << tree.size() << "\n";
+            if(tree.is_incremental())
+                std::cout << "Rebuild work was pending after " << pending << " erases\n";
+        }
+        else if(cmd == "incremental") { // incremental 1|0 - turn the incremental mode on or off
+            tree.set_incremental(key != 0);
+            std::cout << "Incremental mode " << (tree.is_incremental() ? "on" : "off") << "\n";
+        }
+        else if(cmd == "rebuilding") { // rebuilding - print if rebuild work is pending
+            std::cout << "Rebuild work " << (tree.rebuilding() ? "pending" : "done") << "\n";
+        }
+        else if(cmd == "finish") { // finish - do all pending rebuild work
+            tree.finish_rebuild();
+            std::cout << "Finished rebuild work\n";
+        }
+        else if(cmd == "alpha") { // alpha [a] - set the balance factor to a, and print it
+            if(command.size() > 1)
+                tree.set_alpha(std::stof(command[1]));
+            std::cout << "Alpha: " << tree.get_alpha() << "\n";
+        }
+        else if(cmd == "adaptive") { // adaptive 1|0 - turn the adaptive mode on or off
+            tree.set_adaptive(key != 0);
+            std::cout << "Adaptive mode " << (tree.is_adaptive() ? "on" : "off") << "\n";
+        }
+        else if(cmd == "insert_batch") { // insert_batch key value key value ... - insert an unsorted batch
+            std::vector<std::pair<int, std::string>> elems;
+            for(size_t i = 1; i + 1 < command.size(); i += 2)
+                elems.push_back(std::make_pair(std::stoi(command[i]), command[i + 1]));
+            int inserted = tree.insert_batch(elems.begin(), elems.end());
+            std::cout << "Batch inserted " << inserted << " new keys, size " << tree.size() << "\n";
+        }
+        else if(cmd == "find_batch") { // find_batch key key ... - find a batch of keys
+            std::vector<int> keys;
+            for(size_t i = 1; i < command.size(); i++)
+                keys.push_back(std::stoi(command[i]));
+            std::vector<typename T::iterator> found;
+            tree.find_batch(keys.begin(), keys.end(), std::back_inserter(found));
+            std::cout << "Batch found: ";
+            for(size_t i = 0; i < keys.size(); i++) {
+                if(found[i] == tree.end())
+                    std::cout << "[" << keys[i] << "|-] ";
+                else
+                    std::cout << "[" << found[i]->first << "|" << found[i]->second << "] ";
+            }
+            std::cout << "\n";
+        }
+        else if(cmd == "save") { // save - write the tree to a buffer in the binary format
+            saved.str("");
+            saved.clear(); // a failed restore leaves the stream failed
+            write_binary(saved, tree);
+            std::cout << "Saved " << tree.size() << " elements\n";
+        }
+        else if(cmd == "restore") { // restore - read the buffer into the temporary tree
+            saved.seekg(0);
+            if(read_binary(saved, tmp_tree))
+                std::cout << "Restored " << tmp_tree.size() << " elements\n";
+            else
+                std::cout << "Failed restore\n";
+        }
+        else if(cmd == "corrupt") { // corrupt 0|1 - make the saved header claim 2^62 pairs in runs of 2^32 - 1, or the first value 2^63 long
+            std::string bytes = saved.str();
+            BinaryHeader header;
+            std::memcpy(&header, bytes.data(), sizeof(header));
+            if(key == 0) {
+                header.run_size = UINT32_MAX;
+                header.count = std::uint64_t(1) << 62;
+                std::memcpy(bytes.data(), &header, sizeof(header));
+            } else { // the values follow the keys of the first run, and the first value must have a one byte length
+                std::uint64_t n = std::min<std::uint64_t>(header.count, header.run_size);
+                bytes.replace(sizeof(header) + BinaryHeader::padded(n * sizeof(int)), 1, "\xff\xff\xff\xff\xff\xff\xff\xff\x7f");
+            }
+            saved.str(bytes);
+            std::cout << "Corrupted saved tree\n";
+        }
+        else if(cmd == "select") { // select k - the k-th smallest node
+            auto tmp = tree.select(key);
+            if(tmp == tree.end())
+                std::cout << "No node at index " << key << "\n";
+            else
+                std::cout << "Index " << key << ": [" << tmp->first << "|" << tmp->second << "]\n";
+        }
+        else if(cmd == "rank") { // rank key - number of smaller keys
+            std::cout << "Rank of " << key << ": " << tree.rank(key) << "\n";
+        }
+        else if(cmd == "count") { // count lo hi - number of keys in [lo, hi)
+            int hi = std::stoi(command[2]);
+            std::cout << "Keys in [" << key << ", " << hi << "): " << tree.count_range(key, hi) << "\n";
+        }
+        else if(cmd == "range") { // range lo hi - print the nodes with keys in [lo, hi)
+            int hi = std::stoi(command[2]);
+            std::cout << "Range [" << key << ", " << hi << "): ";
+            for(const auto& p : tree.range(key, hi))
+                std::cout << "[" << p.first << "|" << p.second << "] ";
+            std::cout << "\n";
+        }
+        else if(cmd == "lower_bound") {
+            auto tmp = tree.lower_bound(key);
+            if(tmp == tree.end())
+                std::cout << "lower_bound " << key << ": end\n";
+            else
+                std::cout << "lower_bound " << key << ": [" << tmp->first << "|" << tmp->second << "]\n";
+        }
+        else if(cmd == "upper_bound") {
+            auto tmp = tree.upper_bound(key);
+            if(tmp == tree.end())
+                std::cout << "upper_bound " << key << ": end\n";
+            else
+                std::cout << "upper_bound " << key << ": [" << tmp->first << "|" << tmp->second << "]\n";
+        }
         else if(cmd == "stop") // breaking out of loop
             break;
     }
     std::cout << std::flush;
 }
 
+/**
+ * @brief carries out operations on a persistent tree and its snapshots given the list of commands from cin.
+ *          Snapshots are numbered in the order they are taken, and share the comparator of tree.
+ * @param tree
+ */
+template<typename T>
+void PST(T& tree) {
+    std::vector<T> snaps;
+    auto print = [](const char* name, const T& t) {
+        std::cout << name << " (" << t.size() << "): ";
+        for(const auto& p : t)
+            std::cout << "[" << p.first << "|" << p.second << "] ";
+        std::cout << "\n";
+    };
+    for (std::string line; std::getline(std::cin, line);) { // parse each line
+        std::vector<std::string> command = tokenize(line, " ");
+        int key = 0;
+        std::string value = "";
+        if(command.size() > 1)
+            key = std::stoi(command[1]);
+        if(command.size() > 2)
+            value = command[2];
+        auto cmd = command[0];
+
+        if(cmd == "insert") {
+            if(tree.insert(key, value))
+                std::cout << "Inserted: [" << key << "|" << value << "]\n";
+            else
+                std::cout << "Unchanged: " << key << "\n";
+        } else if(cmd == "erase") {
+            tree.erase(key);
+            std::cout << "Erased node: " << key << "\n";
+        } else if(cmd == "find") {
+            auto it = tree.find(key);
+            if(it == tree.end())
+                std::cout << "Not found: " << key << "\n";
+            else
+                std::cout << "[" << it->first << "|" << it->second << "]\n";
+        } else if(cmd == "lower_bound") {
+            auto it = tree.lower_bound(key);
+            if(it == tree.end())
+                std::cout << "lower_bound " << key << ": end\n";
+            else
+                std::cout << "lower_bound " << key << ": [" << it->first << "|" << it->second << "]\n";
+        } else if(cmd == "size") {
+            std::cout << tree.size() << "\n";
+        } else if(cmd == "empty") {
+            std::cout << (tree.empty() ? "Tree is empty" : "Tree is not empty") << "\n";
+        } else if(cmd == "clear") {
+            tree.clear();
+            std::cout << "Cleared Tree\n";
+        } else if(cmd == "print") {
+            print("Print", tree);
+        } else if(cmd == "load") { // load key value key value ... - build the tree from a sorted range
+            std::vector<std::pair<int, std::string>> elems;
+            for(size_t i = 1; i + 1 < command.size(); i += 2)
+                elems.push_back(std::make_pair(std::stoi(command[i]), command[i + 1]));
+            tree = T(elems.begin(), elems.end(), tree.key_comp());
+            std::cout << "Loaded " << tree.size() << " elements\n";
+        } else if(cmd == "insert_range") { // insert_range lo hi - insert the keys in [lo, hi), each with its key as value
+            int hi = std::stoi(command[2]);
+            for(int k = key; k < hi; k++)
+                tree.insert(k, std::to_string(k));
+            std::cout << "Inserted keys in [" << key << ", " << hi << "), size " << tree.size() << "\n";
+        } else if(cmd == "erase_range") { // erase_range lo hi - erase the keys in [lo, hi)
+            int hi = std::stoi(command[2]);
+            for(int k = key; k < hi; k++)
+                tree.erase(k);
+            std::cout << "Erased keys in [" << key << ", " << hi << "), size " << tree.size() << "\n";
+        } else if(cmd == "snapshot") { // snapshot - take a snapshot of the tree
+            snaps.push_back(tree.snapshot());
+            std::cout << "Snapshot " << snaps.size() - 1 << " of " << tree.size() << " elements\n";
+        } else if(cmd == "print_snap") { // print_snap i - print snapshot i
+            print(("Snapshot " + std::to_string(key)).c_str(), snaps[key]);
+        } else if(cmd == "insert_snap") { // insert_snap i key value - insert into snapshot i, not into the tree
+            snaps[key].insert(std::stoi(command[2]), command[3]);
+            std::cout << "Inserted into snapshot " << key << ": [" << command[2] << "|" << command[3] << "]\n";
+        } else if(cmd == "erase_snap") { // erase_snap i key - erase from snapshot i, not from the tree
+            snaps[key].erase(std::stoi(command[2]));
+            std::cout << "Erased from snapshot " << key << ": " << command[2] << "\n";
+        } else if(cmd == "drop_snap") { // drop_snap i - empty snapshot i, which frees the nodes only it used
+            snaps[key].clear();
+            std::cout << "Dropped snapshot " << key << "\n";
+        } else if(cmd == "restore") { // restore i - make the tree share snapshot i
+            tree = snaps[key];
+            std::cout << "Restored snapshot " << key << "\n";
+        } else if(cmd == "stop") { // breaking out of loop
+            break;
+        }
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * @brief carries out operations on a concurrent queue given the list of commands from cin.
+ *          Everything runs on one thread, so the order is checked exactly, see stress.cpp for the threaded tests.
+ */
+void CQ() {
+    ConcurrentQueue<std::string> queue;
+    for (std::string line; std::getline(std::cin, line);) { // parse each line
+        std::vector<std::string> command = tokenize(line, " ");
+        auto cmd = command[0];
+
+        if(cmd == "push") { // push value value ... - push_back the values in order
+            for(size_t i = 1; i < command.size(); i++)
+                queue.push_back(command[i]);
+            std::cout << "Pushed " << command.size() - 1 << " elements\n";
+        } else if(cmd == "pop") { // pop - try_pop_front
+            auto elem = queue.try_pop_front();
+            if(elem)
+                std::cout << "Popped: " << *elem << "\n";
+            else
+                std::cout << "Queue is empty\n";
+        } else if(cmd == "drain") { // drain [max] - pop up to max elements, and print them in order
+            int max = command.size() > 1 ? std::stoi(command[1]) : INT_MAX;
+            std::cout << "Drained: ";
+            int n = queue.drain([](std::string&& elem) { std::cout << elem << " "; }, max);
+            std::cout << "(" << n << ")\n";
+        } else if(cmd == "drain_list") { // drain_list [max] - pop up to max elements into a list, and print the list
+            int max = command.size() > 1 ? std::stoi(command[1]) : INT_MAX;
+            List<std::string> list;
+            int n = queue.drain(list, max);
+            std::cout << "Drained " << n << " into list: ";
+            for(const auto& elem : list)
+                std::cout << elem << " -> ";
+            std::cout << "NULL\n";
+        } else if(cmd == "empty") {
+            std::cout << (queue.empty() ? "Queue is empty" : "Queue is not empty") << "\n";
+        } else if(cmd == "stop") { // breaking out of loop
+            break;
+        }
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * @brief An object for the intrusive containers, which is in an IntrusiveList and an IntrusiveTree through its two hooks.
+ */
+struct Item {
+    int key;
+    std::string value;
+    ListHook<Item> order;
+    TreeHook<Item> by_key;
+};
+
+/**
+ * @brief Key of an Item, for IntrusiveTree.
+ */
+struct ItemKey {
+    int operator()(const Item& item) const {
+        return item.key;
+    }
+};
+
+/**
+ * @brief carries out operations given the list of commands from cin, on objects which are linked into
+ *          an IntrusiveList in the order they were inserted or moved, and an IntrusiveTree by key.
+ *          The objects live in a deque, which never moves them, and stay there after they are unlinked.
+ */
+void INT() {
+    std::deque<Item> items;
+    IntrusiveList<Item, &Item::order> list;
+    IntrusiveTree<Item, &Item::by_key, ItemKey> tree;
+    auto unlink = [&](Item& item) {
+        tree.erase(item);
+        list.erase(item);
+    };
+    for (std::string line; std::getline(std::cin, line);) { // parse each line
+        std::vector<std::string> command = tokenize(line, " ");
+        int key = 0;
+        std::string value = "";
+        if(command.size() > 1)
+            key = std::stoi(command[1]);
+        if(command.size() > 2)
+            value = command[2];
+        auto cmd = command[0];
+
+        if(cmd == "insert") { // insert key value - link a new object at the back of the list and into the tree
+            Item& item = items.emplace_back(Item{key, value, {}, {}});
+            if(tree.insert(item).second) {
+                list.push_back(item);
+                std::cout << "Inserted: [" << key << "|" << value << "]\n";
+            } else
+                std::cout << "Failed insert\n";
+        } else if(cmd == "insert_range") { // insert_range lo hi - insert the keys in [lo, hi), each with its key as value
+            int hi = std::stoi(command[2]);
+            for(int k = key; k < hi; k++) {
+                Item& item = items.emplace_back(Item{k, std::to_string(k), {}, {}});
+                if(tree.insert(item).second)
+                    list.push_back(item);
+            }
+            std::cout << "Inserted keys in [" << key << ", " << hi << "), size " << tree.size() << "\n";
+        } else if(cmd == "erase") { // erase key - unlink the object from both
+            auto it = tree.find(key);
+            if(it != tree.end()) {
+                unlink(*it);
+                std::cout << "Erased node: " << key << "\n";
+            } else
+                std::cout << "Not found: " << key << "\n";
+        } else if(cmd == "erase_from") { // erase_from key n - erase n objects from the lower bound of key on, through tree iterators
+            int n = std::stoi(command[2]);
+            auto it = tree.lower_bound(key);
+            for(int i = 0; i < n && it != tree.end(); i++) {
+                list.erase(*it);
+                it = tree.erase(it);
+            }
+            if(it == tree.end())
+                std::cout << "Erased up to the end\n";
+            else
+                std::cout << "Erased up to: " << it->key << "\n";
+        } else if(cmd == "find") {
+            auto it = tree.find(key);
+            if(it == tree.end())
+                std::cout << "Not found: " << key << "\n";
+            else
+                std::cout << "[" << it->key << "|" << it->value << "]\n";
+        } else if(cmd == "lower_bound") {
+            auto it = tree.lower_bound(key);
+            if(it == tree.end())
+                std::cout << "lower_bound " << key << ": end\n";
+            else
+                std::cout << "lower_bound " << key << ": [" << it->key << "|" << it->value << "]\n";
+        } else if(cmd == "front") { // front - move the object to the front of the list
+            list.move_to_front(*tree.find(key));
+            std::cout << "Moved to front: " << key << "\n";
+        } else if(cmd == "back") { // back - move the object to the back of the list
+            list.move_to_back(*tree.find(key));
+            std::cout << "Moved to back: " << key << "\n";
+        } else if(cmd == "pop_front") { // pop_front - unlink the first object of the list from both
+            if(!list.empty()) {
+                std::cout << "Popped front: " << list.front().key << "\n";
+                tree.erase(list.front());
+                list.pop_front();
+            }
+        } else if(cmd == "pop_back") { // pop_back - unlink the last object of the list from both
+            if(!list.empty()) {
+                std::cout << "Popped back: " << list.back().key << "\n";
+                tree.erase(list.back());
+                list.pop_back();
+            }
+        } else if(cmd == "size") {
+            std::cout << tree.size() << " " << list.size() << "\n";
+        } else if(cmd == "empty") {
+            std::cout << (tree.empty() && list.empty() ? "Empty" : "Not empty") << "\n";
+        } else if(cmd == "clear") {
+            tree.clear();
+            list.clear();
+            std::cout << "Cleared\n";
+        } else if(cmd == "print") { // print - the objects by key
+            std::cout << "Print: ";
+            for(const Item& item : tree)
+                std::cout << "[" << item.key << "|" << item.value << "] ";
+            std::cout << "\n";
+        } else if(cmd == "print_list") { // print_list - the objects in list order
+            for(const Item& item : list)
+                std::cout << item.key << " -> ";
+            std::cout << "NULL\n";
+        } else if(cmd == "check") { // check - walk both forwards and backwards, and check the order and the sizes
+            int forward = 0, backward = 0, wrong = 0, prev = INT_MIN;
+            for(const Item& item : tree) {
+                wrong += item.key <= prev && forward > 0;
+                prev = item.key;
+                forward++;
+            }
+            for(auto it = tree.end(); it != tree.begin();) {
+                --it;
+                backward++;
+            }
+            int in_list = 0;
+            for(auto it = list.end(); it != list.begin();) {
+                --it;
+                wrong += tree.iterator_to(*it) != tree.find(it->key);
+                in_list++;
+            }
+            wrong += forward != tree.size() || backward != tree.size() || in_list != list.size() || list.size() != tree.size();
+            std::cout << "Checked " << forward << " objects, " << wrong << " wrong\n";
+        } else if(cmd == "stop") { // breaking out of loop
+            break;
+        }
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * @brief carries out operations on a cache given the list of commands from cin. Evictions are printed by the evict function.
+ * @param cache LruCache or LfuCache.
+ */
+template<typename C>
+void CACHE(C& cache) {
+    for (std::string line; std::getline(std::cin, line);) { // parse each line
+        std::vector<std::string> command = tokenize(line, " ");
+        int key = 0;
+        std::string value = "";
+        if(command.size() > 1)
+            key = std::stoi(command[1]);
+        if(command.size() > 2)
+            value = command[2];
+        auto cmd = command[0];
+
+        if(cmd == "put") {
+            if(cache.put(key, value))
+                std::cout << "Put: [" << key << "|" << value << "]\n";
+            else
+                std::cout << "Updated: [" << key << "|" << value << "]\n";
+        } else if(cmd == "get") { // get key - counts as a use
+            std::string* v = cache.get(key);
+            if(v)
+                std::cout << "[" << key << "|" << *v << "]\n";
+            else
+                std::cout << "Miss: " << key << "\n";
+        } else if(cmd == "peek") { // peek key - does not count as a use
+            const std::string* v = cache.peek(key);
+            if(v)
+                std::cout << "Peek: [" << key << "|" << *v << "]\n";
+            else
+                std::cout << "Miss: " << key << "\n";
+        } else if(cmd == "contains") {
+            std::cout << key << (cache.contains(key) ? " is cached" : " is not cached") << "\n";
+        } else if(cmd == "frequency") { // frequency key - uses of the entry, only in the LFU cache
+            if constexpr(requires { cache.frequency(key); })
+                std::cout << "Frequency of " << key << ": " << cache.frequency(key) << "\n";
+        } else if(cmd == "erase") {
+            if(cache.erase(key))
+                std::cout << "Erased: " << key << "\n";
+            else
+                std::cout << "Not cached: " << key << "\n";
+        } else if(cmd == "evict") {
+            cache.evict();
+        } else if(cmd == "capacity") { // capacity n - set the capacity, which evicts until the cache fits
+            cache.set_capacity(key);
+            std::cout << "Capacity: " << cache.capacity() << "\n";
+        } else if(cmd == "size") {
+            std::cout << cache.size() << "\n";
+        } else if(cmd == "empty") {
+            std::cout << (cache.empty() ? "Cache is empty" : "Cache is not empty") << "\n";
+        } else if(cmd == "clear") {
+            cache.clear();
+            std::cout << "Cleared cache\n";
+        } else if(cmd == "stop") { // breaking out of loop
+            break;
+        }
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * @brief carries out operations on a Scapegoat tree which counts what it does, given the list of commands from cin.
+ *          The counters do not depend on the machine, except the build time, which is not printed.
+ */
+void STATS() {
+    Tree<int, int, std::less<int>, TreeStats> tree;
+    for (std::string line; std::getline(std::cin, line);) { // parse each line
+        std::vector<std::string> command = tokenize(line, " ");
+        int key = 0;
+        int hi = 0;
+        if(command.size() > 1)
+            key = std::stoi(command[1]);
+        if(command.size() > 2)
+            hi = std::stoi(command[2]);
+        auto cmd = command[0];
+
+        if(cmd == "insert_range") { // insert_range lo hi - insert the keys in [lo, hi) one by one
+            for(int k = key; k < hi; k++)
+                tree.insert(k, k);
+            std::cout << "Inserted keys in [" << key << ", " << hi << "), size " << tree.size() << "\n";
+        } else if(cmd == "erase_range") { // erase_range lo hi - erase the keys in [lo, hi) one by one
+            for(int k = key; k < hi; k++)
+                tree.erase(k);
+            std::cout << "Erased keys in [" << key << ", " << hi << "), size " << tree.size() << "\n";
+        } else if(cmd == "find_range") { // find_range lo hi - find the keys in [lo, hi) one by one
+            int found = 0;
+            for(int k = key; k < hi; k++)
+                found += tree.find(k) != tree.end();
+            std::cout << "Found " << found << " keys in [" << key << ", " << hi << ")\n";
+        } else if(cmd == "fill") { // fill lo hi - bulk load the keys in [lo, hi)
+            std::vector<std::pair<int, int>> elems;
+            for(int k = key; k < hi; k++)
+                elems.push_back(std::make_pair(k, k));
+            tree.assign(elems.begin(), elems.end());
+            std::cout << "Filled " << tree.size() << " elements\n";
+        } else if(cmd == "alpha") { // alpha a - set the balance factor
+            tree.set_alpha(std::stof(command[1]));
+            std::cout << "Alpha: " << tree.get_alpha() << "\n";
+        } else if(cmd == "stats") { // stats - print the counters
+            auto c = tree.statistics();
+            std::cout << "Searches " << c.searches << ", comparisons " << c.comparisons << ", mean depth " << c.mean_depth()
+                      << ", rebuilds " << c.rebuilds << ", rebuilt nodes " << c.rebuilt_nodes << ", full rebuilds " << c.full_rebuilds
+                      << ", bulk builds " << c.bulk_builds << ", allocations " << c.allocations << "\n";
+        } else if(cmd == "reset") { // reset - set the counters to zero
+            tree.reset_statistics();
+            std::cout << "Reset statistics\n";
+        } else if(cmd == "copy") { // copy - print the counters of a copy, which start from zero and count the copied nodes
+            auto copy = tree;
+            auto c = copy.statistics();
+            std::cout << "Copy: rebuilds " << c.rebuilds << ", allocations " << c.allocations << "\n";
+        } else if(cmd == "stop") { // breaking out of loop
+            break;
+        }
+    }
+    std::cout << std::flush;
+}
+
+/**
+ * @brief Describes find(), lower_bound() and upper_bound() of a key in a frozen tree.
+ *
+ * @param frozen tree to search.
+ * @param key to search for.
+ * @return std::string the found pairs, "end" for past the end.
+ */
+template<typename F, typename K>
+std::string frozen_lookup(const F& frozen, K key) {
+    auto show = [&frozen](auto it) {
+        std::ostringstream os;
+        if(it == frozen.end())
+            os << "end";
+        else
+            os << "[" << it->first << "|" << it->second << "]";
+        return os.str();
+    };
+    return "find " + show(frozen.find(key)) + " lower_bound " + show(frozen.lower_bound(key)) +
+           " upper_bound " + show(frozen.upper_bound(key));
+}
+
 /**
  * @brief Tokenizes the input string using the delimiter.
  *
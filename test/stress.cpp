@@ -0,0 +1,320 @@
+#include "../src/ConcurrentTree.hpp"
+#include "../src/ShardedTree.hpp"
+#include "../src/PersistentTree.hpp"
+#include "../src/Tree.hpp"
+
+#include <stdlib.h>
+#include <algorithm>
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <set>
+#include <string.h>
+#include <thread>
+#include <vector>
+#include <utility>
+
+using namespace DM852;
+
+bool concurrent_tree();
+bool sharded_tree();
+bool persistent_tree();
+bool parallel_tree();
+
+/**
+ * @brief Threaded stress tests of the concurrent containers. Build with "make stress", which uses the thread sanitizer,
+ *        so a data race is reported even if the checks below pass.
+ *        "./stress.out CONC" runs the test of ConcurrentTree, "SHARD" the one of ShardedTree, "PERSIST" the one of PersistentTree
+ *        and "PAR" the one of the bulk operations of Tree with several threads. Without arguments all tests are run.
+ * @return int 0 if all checks passed.
+ */
+int main(int argc, char **argv) {
+    bool all = argc == 1;
+    bool ok = true;
+    if(all || strcmp(argv[1], "CONC") == 0)
+        ok &= concurrent_tree();
+    if(all || strcmp(argv[1], "SHARD") == 0)
+        ok &= sharded_tree();
+    if(all || strcmp(argv[1], "PERSIST") == 0)
+        ok &= persistent_tree();
+    if(all || strcmp(argv[1], "PAR") == 0)
+        ok &= parallel_tree();
+    std::cout << (ok ? "Stress tests passed" : "Stress tests FAILED") << std::endl;
+    return ok ? 0 : 1;
+}
+
+/**
+ * @brief Prints the result of a test.
+ * @param name of the test.
+ * @param bad number of failed checks.
+ * @return true if no check failed.
+ */
+bool report(const char* name, long bad) {
+    std::cout << name << ": " << (bad == 0 ? "OK" : "FAILED") << ", " << bad << " bad results" << std::endl;
+    return bad == 0;
+}
+
+/**
+ * @brief Readers search a ConcurrentTree while two writers insert, erase, assign and insert batches.
+ *          Every value is twice its key, so a reader can check every value it sees,
+ *          and a range must always come out sorted.
+ * @return true if no reader saw a wrong value or an unsorted range, and the final tree is right.
+ */
+bool concurrent_tree() {
+    ConcurrentTree<int, long> tree;
+    constexpr int keys = 20000;
+    for(int k = 0; k < keys; k += 2)
+        tree.insert(k, 2L * k);
+    std::atomic<bool> stop = false;
+    std::atomic<long> bad = 0;
+    std::vector<std::thread> readers;
+    for(int r = 0; r < 4; r++) {
+        readers.emplace_back([&, r] {
+            std::mt19937 rng(r);
+            for(long n = 0; !stop; n++) {
+                int k = rng() % keys;
+                auto v = tree.find(k);
+                if(v && *v != 2L * k)
+                    bad++;
+                if(n % 64 == 0) {
+                    bad += tree.read([k](const auto& t) {
+                        long prev = -1, wrong = 0;
+                        for(const auto& p : t.range(k, k + 200)) {
+                            wrong += p.first <= prev || p.second != 2L * p.first;
+                            prev = p.first;
+                        }
+                        return wrong;
+                    });
+                }
+            }
+        });
+    }
+    std::vector<std::thread> writers;
+    for(int w = 0; w < 2; w++) {
+        writers.emplace_back([&, w] {
+            std::mt19937 rng(100 + w);
+            for(int i = 0; i < 400; i++) {
+                int k = rng() % keys;
+                switch(i % 4) {
+                    case 0: tree.insert(k, 2L * k); break;
+                    case 1: tree.erase(k); break;
+                    case 2: tree.insert_or_assign(k, 2L * k); break;
+                }
+                if(i % 4 == 3) {
+                    tree.write([&](auto& t) {
+                        std::vector<std::pair<int, long>> batch;
+                        for(int j = 0; j < 50; j++) {
+                            int b = rng() % keys;
+                            batch.emplace_back(b, 2L * b);
+                        }
+                        t.insert_batch(batch.begin(), batch.end());
+                    });
+                }
+            }
+        });
+    }
+    for(auto& t : writers)
+        t.join();
+    stop = true;
+    for(auto& t : readers)
+        t.join();
+    // both copies of the tree must have the same content
+    long size = tree.read([](const auto& t) { return t.size(); });
+    int count = 0;
+    for(int k = 0; k < keys; k++)
+        count += tree.contains(k);
+    bad += size != tree.size() || count != size;
+    return report("ConcurrentTree", bad);
+}
+
+/**
+ * @brief Four writers change a ShardedTree at the same time, each its own keys (the keys k with k % 4 == w),
+ *          while a reader walks the whole map and ranges of it in sorted order. Afterwards the content
+ *          must be exactly what the writers left, which they track in their own sets.
+ *          Every value is twice its key, so the reader can check every pair it sees.
+ * @return true if the reader saw no wrong pair and the final content is right.
+ */
+bool sharded_tree() {
+    ShardedTree<int, long> tree(8);
+    constexpr int keys = 40000;
+    constexpr int writers = 4;
+    std::vector<std::set<int>> expected(writers);
+    std::atomic<bool> stop = false;
+    std::atomic<long> bad = 0;
+    std::thread reader([&] {
+        while(!stop) {
+            long prev = -1, wrong = 0;
+            tree.for_each([&](const auto& p) {
+                wrong += p.first <= prev || p.second != 2L * p.first;
+                prev = p.first;
+            });
+            prev = 99;
+            tree.for_each(100, 5000, [&](const auto& p) {
+                wrong += p.first <= prev || p.first >= 5000 || p.second != 2L * p.first;
+                prev = p.first;
+            });
+            bad += wrong;
+        }
+    });
+    std::vector<std::thread> threads;
+    for(int w = 0; w < writers; w++) {
+        threads.emplace_back([&, w] {
+            std::mt19937 rng(200 + w);
+            std::set<int>& mine = expected[w];
+            for(int i = 0; i < 20000; i++) {
+                int k = (rng() % (keys / writers)) * writers + w;
+                switch(i % 3) {
+                    case 0:
+                        bad += tree.insert(k, 2L * k) == mine.count(k); // true only for a new key
+                        mine.insert(k);
+                        break;
+                    case 1:
+                        tree.erase(k);
+                        mine.erase(k);
+                        break;
+                    default:
+                        tree.insert_or_assign(k, 2L * k);
+                        mine.insert(k);
+                }
+                auto v = tree.find(k);
+                bad += v.has_value() != bool(mine.count(k)) || (v && *v != 2L * k);
+            }
+            std::vector<std::pair<int, long>> batch; // load() inserts into all shards in parallel
+            for(int j = 0; j < 200; j++) {
+                int k = (rng() % (keys / writers)) * writers + w;
+                batch.emplace_back(k, 2L * k);
+                mine.insert(k);
+            }
+            tree.load(batch.begin(), batch.end());
+        });
+    }
+    for(auto& t : threads)
+        t.join();
+    stop = true;
+    reader.join();
+    std::set<int> all;
+    for(const auto& mine : expected)
+        all.insert(mine.begin(), mine.end());
+    std::vector<int> found;
+    tree.for_each([&found](const auto& p) { found.push_back(p.first); });
+    bad += tree.size() != int(all.size()) || !std::equal(found.begin(), found.end(), all.begin(), all.end());
+    ShardedTree<int, long, std::greater<int>> desc(8, std::hash<int>(), std::greater<int>()); // merge must follow Comp
+    for(int k = 0; k < 1000; k++)
+        desc.insert(k, 2L * k);
+    found.clear();
+    desc.for_each([&found](const auto& p) { found.push_back(p.first); });
+    bad += !std::is_sorted(found.begin(), found.end(), std::greater<int>()) || found.size() != 1000;
+    found.clear();
+    desc.for_each(500, 100, [&found](const auto& p) { found.push_back(p.first); });
+    bad += found.size() != 400 || found.front() != 500 || found.back() != 101;
+    return report("ShardedTree", bad);
+}
+
+/**
+ * @brief Snapshots of a PersistentTree are handed to reader threads, which walk and then destroy them,
+ *          while the main thread keeps changing the tree, and so copies and frees nodes the snapshots share.
+ *          Every value in a snapshot is the version it was taken at plus its key, so a reader can check
+ *          that it sees exactly the version it was given.
+ * @return true if every snapshot had its own size, order and values, and the final tree is right.
+ */
+bool persistent_tree() {
+    PersistentTree<int, long> tree;
+    constexpr int keys = 20000;
+    for(int k = 0; k < keys; k++)
+        tree.insert(k, k);
+    std::atomic<long> bad = 0;
+    std::vector<std::thread> readers;
+    std::set<int> expected;
+    for(int k = 0; k < keys; k++)
+        expected.insert(k);
+    for(long version = 0; version < 6; version++) {
+        auto snap = tree.snapshot();
+        long n = snap.size();
+        readers.emplace_back([&bad, snap = std::move(snap), n, version]() mutable {
+            for(int pass = 0; pass < 3; pass++) {
+                long prev = -1, count = 0;
+                for(const auto& p : snap) {
+                    bad += p.first <= prev || p.second != version * keys + p.first;
+                    prev = p.first;
+                    count++;
+                }
+                bad += count != n;
+            }
+            snap.clear(); // frees the nodes no other version uses
+        });
+        // the next version: new values for all keys, then a tenth of the keys erased or inserted again
+        std::mt19937 rng(300 + version);
+        for(int k = 0; k < keys; k++) {
+            if(expected.count(k))
+                tree.insert(k, (version + 1) * keys + k);
+        }
+        for(int i = 0; i < keys / 10; i++) {
+            int k = rng() % keys;
+            if(expected.count(k)) {
+                tree.erase(k);
+                expected.erase(k);
+            } else {
+                tree.insert(k, (version + 1) * keys + k);
+                expected.insert(k);
+            }
+        }
+    }
+    for(auto& t : readers)
+        t.join();
+    std::vector<int> found;
+    for(const auto& p : tree) {
+        found.push_back(p.first);
+        bad += p.second != 6L * keys + p.first;
+    }
+    bad += tree.size() != long(expected.size()) || !std::equal(found.begin(), found.end(), expected.begin(), expected.end());
+    return report("PersistentTree", bad);
+}
+
+/**
+ * @brief Runs the bulk operations of a Tree with four threads on trees much bigger than Tree::parallel_cutoff,
+ *          so the builds, the copy and parallel_for_each() are really split over threads: assign, copy,
+ *          parallel_for_each() changing and reading the values, set_union(), split() and join().
+ *          Every value is twice its key, so the result can be checked pair by pair.
+ * @return true if all trees have the right size and pairs.
+ */
+bool parallel_tree() {
+    constexpr int keys = 8 * Tree<int, long>::parallel_cutoff;
+    long bad = 0;
+    auto check = [&bad](const Tree<int, long>& t, int size) {
+        std::atomic<long> pairs = 0, wrong = 0;
+        t.parallel_for_each([&](const auto& p) {
+            pairs++;
+            wrong += p.second != 2L * p.first;
+        });
+        long prev = -1;
+        for(const auto& p : t) {
+            wrong += p.first <= prev;
+            prev = p.first;
+        }
+        bad += wrong + (pairs != size) + (t.size() != size);
+    };
+    Tree<int, long> even, odd;
+    even.set_threads(4);
+    odd.set_threads(4);
+    std::vector<std::pair<int, long>> elems;
+    for(int k = 0; k < keys; k += 2)
+        elems.emplace_back(k, k);
+    even.assign(elems.begin(), elems.end());
+    even.parallel_for_each([](auto& p) { p.second *= 2; });
+    check(even, keys / 2);
+    elems.clear();
+    for(int k = 1; k < keys; k += 2)
+        elems.emplace_back(k, 2L * k);
+    odd.assign(elems.begin(), elems.end());
+    Tree<int, long> all = even;
+    check(all, keys / 2);
+    all.set_threads(4);
+    all.set_union(odd);
+    check(all, keys);
+    Tree<int, long> high = all.split(keys / 4);
+    check(all, keys / 4);
+    check(high, keys - keys / 4);
+    all = Tree<int, long>::join(std::move(all), std::move(high));
+    check(all, keys);
+    return report("Parallel Tree", bad);
+}